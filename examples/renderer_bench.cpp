@@ -1,5 +1,7 @@
+#include "PrimeManifest/renderer/Autotuner.hpp"
 #include "PrimeManifest/renderer/Optimizer2D.hpp"
 #include "PrimeManifest/renderer/Renderer2D.hpp"
+#include "PrimeManifest/text/TextBake.hpp"
 
 #include <algorithm>
 #include <array>
@@ -36,6 +38,7 @@ struct BenchConfig {
   uint16_t rectRadius = 4;
   uint16_t circleRadius = 4;
   bool enableText = true;
+  bool textSprites = false;
   bool enableDebugTiles = false;
   bool useTileStream = false;
   bool dump = false;
@@ -45,7 +48,12 @@ struct BenchConfig {
   bool disableOpaqueRectFastPath = false;
   bool reuseOptimized = false;
   bool assumeFrontToBack = true;
+  bool sortByZ = false;
   bool autoTileStream = true;
+  bool adaptiveTiles = true;
+  bool packRectRecords = true;
+  bool autotune = false;
+  std::string autotunePath;
   uint32_t seed = 1337;
 };
 
@@ -97,6 +105,8 @@ auto parse_args(int argc, char** argv) -> BenchConfig {
       cfg.reuseOptimized = true;
     } else if (arg == "--no-text") {
       cfg.enableText = false;
+    } else if (arg == "--text-sprites") {
+      cfg.textSprites = true;
     } else if (arg == "--debug-tiles") {
       cfg.enableDebugTiles = true;
     } else if (arg == "--tile-stream") {
@@ -120,6 +130,17 @@ auto parse_args(int argc, char** argv) -> BenchConfig {
       cfg.assumeFrontToBack = true;
     } else if (arg == "--no-front-to-back") {
       cfg.assumeFrontToBack = false;
+    } else if (arg == "--sort-z") {
+      cfg.sortByZ = true;
+    } else if (arg == "--no-adaptive-tiles") {
+      cfg.adaptiveTiles = false;
+    } else if (arg == "--rect-soa") {
+      cfg.packRectRecords = false;
+    } else if (arg == "--autotune") {
+      cfg.autotune = true;
+      if (i + 1 < argc && argv[i + 1][0] != '-') {
+        cfg.autotunePath = argv[++i];
+      }
     } else if (arg == "--auto-tile-stream") {
       cfg.autoTileStream = true;
     } else if (arg == "--no-auto-tile-stream") {
@@ -846,6 +867,9 @@ int main(int argc, char** argv) {
   batch.disableOpaqueRectFastPath = cfg.disableOpaqueRectFastPath;
   batch.reuseOptimized = cfg.reuseOptimized;
   batch.assumeFrontToBack = cfg.assumeFrontToBack;
+  batch.sortByZ = cfg.sortByZ;
+  batch.adaptiveTiles = cfg.adaptiveTiles;
+  batch.packRectRecords = cfg.packRectRecords;
   batch.autoTileStream = cfg.autoTileStream;
   batch.useCommandRevision = true;
 
@@ -940,6 +964,12 @@ int main(int argc, char** argv) {
       int32_t y = yDist(rng);
       uint8_t textIndex = 255;
       add_text(batch, x, y, 120, 24, textIndex, runIndex);
+      if (cfg.textSprites) {
+        batch.text.flags.back() |= TextFlagSprite;
+      }
+    }
+    if (cfg.textSprites) {
+      BuildTextRunSprite(batch, runIndex);
     }
   }
 
@@ -959,7 +989,11 @@ int main(int argc, char** argv) {
   RenderTarget target{std::span<uint8_t>(buffer), cfg.width, cfg.height, cfg.width * 4};
   OptimizedBatch optimized;
   bool dynamicCircles = !circleBaseY.empty();
-  bool renderOnly = cfg.useOptimized && !dynamicCircles;
+  bool renderOnly = cfg.useOptimized && !dynamicCircles && !cfg.autotune;
+  RenderAutotuner tuner;
+  if (cfg.autotune && !cfg.autotunePath.empty()) {
+    tuner.load(cfg.autotunePath);
+  }
   if (renderOnly) {
     OptimizeRenderBatch(target, batch, optimized);
   }
@@ -1033,10 +1067,16 @@ int main(int argc, char** argv) {
       RenderOptimized(target, batch, optimized);
       continue;
     }
+    if (cfg.autotune) {
+      tuner.apply(batch, cfg.width, cfg.height);
+    }
     if (!canReuseOptimized()) {
       OptimizeRenderBatch(target, batch, optimized);
     }
     RenderOptimized(target, batch, optimized);
+    if (cfg.autotune) {
+      tuner.record(batch);
+    }
   }
   auto end = std::chrono::steady_clock::now();
   std::chrono::duration<double> elapsed = end - start;
@@ -1063,7 +1103,22 @@ int main(int argc, char** argv) {
   std::cout << "TileStream: " << (cfg.useTileStream ? "Enabled" : "Disabled") << "\n";
   std::cout << "ReuseOptimized: " << (cfg.reuseOptimized ? "Enabled" : "Disabled") << "\n";
   std::cout << "FrontToBack: " << (cfg.assumeFrontToBack ? "Enabled" : "Disabled") << "\n";
+  std::cout << "SortByZ: " << (cfg.sortByZ ? "Enabled" : "Disabled") << "\n";
   std::cout << "AutoTileStream: " << (cfg.autoTileStream ? "Enabled" : "Disabled") << "\n";
+  std::cout << "AdaptiveTiles: " << (cfg.adaptiveTiles ? "Enabled" : "Disabled") << "\n";
+  std::cout << "RectLayout: " << (cfg.packRectRecords ? "Packed" : "SoA") << "\n";
+  if (cfg.autotune) {
+    std::cout << "Autotune: ";
+    if (auto choice = tuner.settled(batch, cfg.width, cfg.height)) {
+      std::cout << "Settled (TileSize " << choice->tileSize
+                << ", AutoTileStream " << (choice->autoTileStream ? "Enabled" : "Disabled") << ")\n";
+    } else {
+      std::cout << "Sampling\n";
+    }
+    if (!cfg.autotunePath.empty() && !tuner.save(cfg.autotunePath)) {
+      std::cerr << "Failed to save autotune decisions to " << cfg.autotunePath << "\n";
+    }
+  }
   std::cout << "Optimized: " << (renderOnly ? "Enabled" : "Disabled") << "\n";
   std::cout << "Elapsed: " << elapsed.count() << "s\n";
   std::cout << "FPS: " << fps << "\n";
@@ -1117,7 +1172,8 @@ int main(int argc, char** argv) {
     std::cout << "Profile: OptRectCache " << optRectCacheMs << "ms"
               << " OptTextCache " << optTextCacheMs << "ms\n";
     std::cout << "Profile: Tiles " << profile.activeTileCount << "/" << profile.tileCount
-              << " Commands " << profile.commandCount << "\n";
+              << " Commands " << profile.commandCount
+              << " Coalesced " << profile.coalescedCommandCount << "\n";
     std::cout << "Profile: WorkerCount " << workerCount
               << " CoreEquiv " << coreEquiv
               << " Util " << utilPct << "%\n";
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "PrimeManifest/renderer/Renderer2D.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace PrimeManifest {
+
+struct RenderTuning {
+  uint16_t tileSize = 32;
+  bool autoTileStream = true;
+};
+
+// Opt-in measured replacement for the fixed tile-size heuristic. Each scene signature (command-type
+// histogram, draw density and target size, bucketed by powers of two) renders a few frames with
+// every candidate tile size and tile-stream mode, timed from RendererProfile build + render time,
+// then settles on the fastest. Callers that set reuseOptimized only pay for builds when the scene
+// changes, so their candidates are scored on render time alone. Bracket each frame with apply()
+// before OptimizeRenderBatch and record() after RenderOptimized.
+class RenderAutotuner {
+public:
+  RenderAutotuner();
+
+  void setCandidateTileSizes(std::span<uint16_t const> sizes);
+  void setSampleFrames(uint32_t frames);
+
+  // Writes this frame's tuning into the batch. While sampling, the optimized batch is rebuilt every
+  // frame and the tuner's own profile is attached when the caller has none; record() restores both.
+  // batch.tileSize and batch.autoTileStream are left holding the applied tuning, not restored.
+  void apply(RenderBatch& batch, uint32_t targetWidth, uint32_t targetHeight);
+  void record(RenderBatch& batch);
+
+  auto settled(RenderBatch const& batch, uint32_t targetWidth, uint32_t targetHeight) const
+      -> std::optional<RenderTuning>;
+  auto settledCount() const -> size_t;
+
+  // Settled decisions only; scenes still sampling are not persisted.
+  auto load(std::string const& path) -> bool;
+  auto save(std::string const& path) const -> bool;
+
+  static auto sceneSignature(RenderBatch const& batch, uint32_t targetWidth, uint32_t targetHeight)
+      -> uint64_t;
+
+private:
+  struct Scene {
+    std::vector<uint64_t> bestNs;
+    uint32_t candidate = 0;
+    uint32_t frames = 0;
+    bool settled = false;
+    RenderTuning choice{};
+  };
+
+  std::vector<RenderTuning> candidates_;
+  uint32_t sampleFrames_ = 3;
+  std::unordered_map<uint64_t, Scene> scenes_;
+  RendererProfile profile_;
+  uint64_t pendingSignature_ = 0;
+  bool pending_ = false;
+  bool restoreReuse_ = false;
+  bool restoreProfile_ = false;
+};
+
+} // namespace PrimeManifest
@@ -19,6 +19,41 @@ struct OptimizedBatch {
     uint32_t ty1 = 0;
   };
 
+  // One render-pool job: `tileCount` consecutive renderTiles entries starting at `first`, or, when
+  // `split` > 1, sub-tile `part` (row-major) of a split x split grid over renderTiles[first].
+  struct TileWorkUnit {
+    uint32_t first = 0;
+    uint16_t tileCount = 1;
+    uint8_t split = 1;
+    uint8_t part = 0;
+  };
+
+  enum RectRecordFlags : uint8_t {
+    RectRecordGradient = 1u << 0,
+    RectRecordClip = 1u << 1,
+  };
+
+  // Hot per-rect render state, two records per cache line. Gradient and clip parameters stay in
+  // the rect cache vectors and are only read when the matching RectRecordFlags bit is set.
+  struct RectRecord {
+    int32_t x0 = 0;
+    int32_t y0 = 0;
+    int32_t x1 = 0;
+    int32_t y1 = 0;
+    uint32_t edgeOffset = 0xFFFFFFFFu;
+    uint16_t radiusQ8_8 = 0;
+    int16_t rotationQ8_8 = 0;
+    uint8_t colorR = 0;
+    uint8_t colorG = 0;
+    uint8_t colorB = 0;
+    uint8_t colorA = 0;
+    uint8_t baseAlpha = 0;
+    uint8_t opacity = 0;
+    uint8_t flags = 0;
+    uint8_t cacheFlags = 0;
+  };
+  static_assert(sizeof(RectRecord) == 32);
+
   uint32_t targetWidth = 0;
   uint32_t targetHeight = 0;
   uint32_t tileSize = 0;
@@ -44,6 +79,7 @@ struct OptimizedBatch {
   uint8_t debugFlags = 0;
   bool valid = false;
   uint64_t sourceRevision = 0;
+  bool sourceAutoTileStream = true;
   uint64_t commandCountsRevision = 0;
   CommandTypeCounts commandTypeCounts{};
 
@@ -58,7 +94,18 @@ struct OptimizedBatch {
   std::vector<uint32_t> tileRefs;
   std::vector<uint32_t> tileFill;
   std::vector<uint32_t> circleTileSpans;
+  // Commands spanning many tiles are binned once here, in bin order, instead of into every tile;
+  // the tile scheduler merges them with each tile's own refs. tileOccluderKeys and cmdZKeys carry
+  // the binning-time occlusion cutoffs and z sort keys the merge needs (empty when unused).
+  std::vector<uint32_t> largeRefs;
+  std::vector<uint64_t> tileOccluderKeys;
+  std::vector<uint16_t> cmdZKeys;
+  // Commands that absorbed a run of abutting same-colour rects or pixels; their cmdTiles bounds
+  // cover the whole run and the rest of the run is not binned.
+  std::vector<uint32_t> coalescedCommands;
   std::vector<uint32_t> renderTiles;
+  // Cost-balanced jobs over renderTiles, most expensive first; empty renders one job per tile.
+  std::vector<TileWorkUnit> tileWork;
   std::vector<uint8_t> textBaseAlpha;
   std::vector<uint8_t> textActive;
   std::vector<uint32_t> textPmOffset;
@@ -74,6 +121,13 @@ struct OptimizedBatch {
   std::vector<int32_t> textClipY0;
   std::vector<int32_t> textClipX1;
   std::vector<int32_t> textClipY1;
+  // Long runs whose glyph left edges are non-decreasing get text-origin-relative glyph spans, so a
+  // tile binary-searches to the first glyph reaching it and stops at the first glyph past it.
+  std::vector<uint32_t> textRunSpanOffset;
+  std::vector<int32_t> textGlyphSpanX0;
+  std::vector<int32_t> textGlyphSpanMaxX1;
+  // Filled for active rects when RenderBatch::packRectRecords is set; empty otherwise.
+  std::vector<RectRecord> rectRecords;
   std::vector<uint8_t> rectBaseAlpha;
   std::vector<uint8_t> rectActive;
   std::vector<uint32_t> rectEdgeOffset;
@@ -125,6 +179,7 @@ struct OptimizedBatch {
     debugFlags = 0;
     valid = false;
     sourceRevision = 0;
+    sourceAutoTileStream = true;
     commandCountsRevision = 0;
     commandTypeCounts.reset();
     mergedTileStream.clear();
@@ -137,7 +192,12 @@ struct OptimizedBatch {
     tileRefs.clear();
     tileFill.clear();
     circleTileSpans.clear();
+    largeRefs.clear();
+    tileOccluderKeys.clear();
+    cmdZKeys.clear();
+    coalescedCommands.clear();
     renderTiles.clear();
+    tileWork.clear();
     textBaseAlpha.clear();
     textActive.clear();
     textPmOffset.clear();
@@ -153,6 +213,10 @@ struct OptimizedBatch {
     textClipY0.clear();
     textClipX1.clear();
     textClipY1.clear();
+    textRunSpanOffset.clear();
+    textGlyphSpanX0.clear();
+    textGlyphSpanMaxX1.clear();
+    rectRecords.clear();
     rectBaseAlpha.clear();
     rectActive.clear();
     rectEdgeOffset.clear();
@@ -7,6 +7,7 @@
 #include <string>
 #include <string_view>
 #include <span>
+#include <unordered_map>
 #include <vector>
 
 #include "PrimeManifest/text/GlyphBitmapFormat.hpp"
@@ -251,6 +252,7 @@ enum RectFlags : uint8_t {
 
 enum TextFlags : uint8_t {
   TextFlagClip = 1u << 0,
+  TextFlagSprite = 1u << 1,
 };
 
 enum DebugTilesFlags : uint8_t {
@@ -307,6 +309,8 @@ struct RendererProfile {
   uint32_t tileCount = 0;
   uint32_t activeTileCount = 0;
   uint32_t commandCount = 0;
+  // Commands the optimizer folded into an abutting same-colour rect or pixel run.
+  uint32_t coalescedCommandCount = 0;
   uint64_t renderedTileCount = 0;
   uint64_t renderedCommandCount = 0;
   uint64_t renderedPixelCount = 0;
@@ -338,6 +342,7 @@ struct RendererProfile {
     tileCount = 0;
     activeTileCount = 0;
     commandCount = 0;
+    coalescedCommandCount = 0;
     renderedTileCount = 0;
     renderedCommandCount = 0;
     renderedPixelCount = 0;
@@ -2318,18 +2323,56 @@ struct TextRunStore {
   std::vector<uint32_t> glyphCount;
   std::vector<int16_t> baselineQ8_8;
   std::vector<uint16_t> scaleQ8_8;
+  std::vector<uint16_t> glyphScaleQ8_8;
+  // Baked run key (TextRun::contentHash plus run scales) -> run index. Batches that keep runs and
+  // glyph placements across frames re-append unchanged text without re-baking its glyphs. An entry
+  // is stale once GlyphStore::placementGeneration moves past the generation it was baked in.
+  struct BakedRun {
+    uint32_t runIndex = 0;
+    uint64_t placementGeneration = 0;
+  };
+  std::unordered_map<uint64_t, BakedRun> bakedLookup;
+  // Set when AppendTextRun bakes or reuses a run; TrimTextRuns drops runs left unset and resets it.
+  std::vector<uint8_t> used;
+
+  // Whole-run A8 coverage composited in one masked blit for text entries flagged TextFlagSprite.
+  // x/y offset the sprite from the text origin.
+  struct Sprite {
+    int32_t x = 0;
+    int32_t y = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+    std::vector<uint8_t> coverage;
+  };
+  static constexpr uint32_t NoSprite = 0xFFFFFFFFu;
+  std::vector<uint32_t> spriteIndex;
+  std::vector<Sprite> sprites;
 
   void clear() {
     glyphStart.clear();
     glyphCount.clear();
     baselineQ8_8.clear();
     scaleQ8_8.clear();
+    glyphScaleQ8_8.clear();
+    bakedLookup.clear();
+    used.clear();
+    spriteIndex.clear();
+    sprites.clear();
   }
   size_t size() const {
     return glyphStart.size();
   }
 };
 
+// Span-encoded Mask8 rows: each token byte is (kind << 6) | (length - 1), and Blend tokens are
+// followed by `length` coverage bytes. Columns past a row's last token are empty.
+enum GlyphSpanKind : uint8_t {
+  GlyphSpanSkip = 0,
+  GlyphSpanSolid = 1,
+  GlyphSpanBlend = 2,
+};
+inline constexpr int32_t GlyphSpanMaxLength = 64;
+
 struct GlyphStore {
   struct GlyphBitmap {
     int32_t width = 0;
@@ -2339,10 +2382,14 @@ struct GlyphStore {
     int32_t advance = 0;
     int32_t stride = 0;
     GlyphBitmapFormat format = GlyphBitmapFormat::Mask8;
+    uint8_t subpixelBin = 0;
     int32_t atlasIndex = -1;
     int32_t atlasX = 0;
     int32_t atlasY = 0;
     std::vector<uint8_t> pixels;
+    // When maskSpanRows holds height + 1 offsets, the glyph is stored as maskSpans instead of pixels.
+    std::vector<uint8_t> maskSpans;
+    std::vector<uint32_t> maskSpanRows;
   };
 
   struct GlyphAtlas {
@@ -2358,6 +2405,13 @@ struct GlyphStore {
   std::vector<GlyphBitmap> bitmaps;
   std::vector<uint8_t> bitmapOpaque;
   std::vector<GlyphAtlas> atlases;
+  // Source GlyphBitmap::identity -> index into bitmaps, shared by every run baked into this store.
+  // Bitmaps without an identity are only shared within one AppendTextRun call.
+  std::unordered_map<GlyphIdentity, uint32_t, GlyphIdentityHash> bitmapLookup;
+  // Bake Mask8 glyphs as span-encoded rows (EncodeGlyphMaskSpans) instead of dense coverage.
+  bool encodeMaskSpans = false;
+  // Advanced whenever placements are dropped, so runs baked before then are not reused.
+  uint64_t placementGeneration = 0;
 
   void clear() {
     glyphXQ8_8.clear();
@@ -2366,6 +2420,15 @@ struct GlyphStore {
     bitmaps.clear();
     bitmapOpaque.clear();
     atlases.clear();
+    bitmapLookup.clear();
+    ++placementGeneration;
+  }
+  // Drops per-frame glyph placements but keeps the baked bitmap table for the next frame.
+  void clearPlacements() {
+    glyphXQ8_8.clear();
+    glyphYQ8_8.clear();
+    bitmapIndex.clear();
+    ++placementGeneration;
   }
   size_t size() const {
     return glyphXQ8_8.size();
@@ -2456,7 +2519,16 @@ struct RenderBatch {
   bool reuseOptimized = false;
   bool strictValidation = false;
   bool assumeFrontToBack = true;
+  // Orders each optimizer-built tile bin by rect/text zQ8_8 (stable, so equal z keeps command
+  // order); higher z draws on top, and comes first when front-to-back order is in effect.
+  bool sortByZ = false;
   bool autoTileStream = true;
+  // Splits tiles with many refs into sub-tiles and merges runs of cheap tiles so render jobs are
+  // cost-balanced across the pool; output is unchanged.
+  bool adaptiveTiles = true;
+  // Packs the per-rect fields the render kernel reads on every draw into one OptimizedBatch::RectRecord
+  // instead of gathering them from the parallel rect cache vectors.
+  bool packRectRecords = true;
   RendererProfile* profile = nullptr;
   RenderValidationReport* validationReport = nullptr;
 
@@ -2485,7 +2557,10 @@ struct RenderBatch {
     reuseOptimized = false;
     strictValidation = false;
     assumeFrontToBack = true;
+    sortByZ = false;
     autoTileStream = true;
+    adaptiveTiles = true;
+    packRectRecords = true;
     validationReport = nullptr;
   }
 };
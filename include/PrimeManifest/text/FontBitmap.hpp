@@ -23,4 +23,13 @@ bool ConvertFontBitmapToAlpha(FontBitmapView view,
                               std::vector<uint8_t>& outPixels,
                               int32_t& outStride);
 
+bool BuildGlyphDistanceField(const uint8_t* coverage,
+                             int32_t width,
+                             int32_t height,
+                             int32_t stride,
+                             int32_t spread,
+                             std::vector<uint8_t>& outPixels,
+                             int32_t& outWidth,
+                             int32_t& outHeight);
+
 } // namespace PrimeManifest
@@ -1,15 +1,27 @@
 #pragma once
 
+#include "PrimeManifest/text/Paragraph.hpp"
 #include "PrimeManifest/text/TextLayout.hpp"
 #include "PrimeManifest/text/Typography.hpp"
 
 #include <memory>
+#include <span>
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 namespace PrimeManifest {
 
+struct FontFaceStats {
+  size_t registered = 0;
+  // Faces whose FT_Face has been opened; the rest are known from their metadata only.
+  size_t opened = 0;
+  // Distinct backing files of registered faces, by how they were loaded.
+  size_t mappedFiles = 0;
+  size_t readFiles = 0;
+};
+
 class FontRegistry {
 public:
   FontRegistry();
@@ -24,14 +36,46 @@ public:
   void loadOsFallbackFonts();
   bool hasBundledFaces() const;
 
+  // OS fallback resolves through a persisted (path, mtime) -> family/weight/slant/coverage index
+  // built in the background. The default location honours PRIMEMANIFEST_FONT_INDEX; an empty
+  // path keeps the index in memory only.
+  void setOsFontIndexPath(std::string path);
+  void buildOsFontIndex();
+  auto waitForOsFontIndex() -> size_t;
+
+  // Printable-ASCII Latin runs without features or locale are laid out from cached per-size
+  // advance/kerning tables instead of hb_shape; the result is identical. On by default.
+  void setLatinFastPathEnabled(bool enabled);
+
+  // Font files are memory-mapped where the platform supports it and read into memory otherwise.
+  // Disabling mapping forces the read path for files loaded afterwards. On by default.
+  void setFontFileMappingEnabled(bool enabled);
+  auto faceStats() const -> FontFaceStats;
+
   auto layoutText(std::string_view text,
                   Typography const& typography,
                   float deviceScale,
                   bool buildGlyphs = true) -> std::shared_ptr<TextRun>;
 
+  auto layoutParagraph(std::string_view text,
+                       Typography const& typography,
+                       float deviceScale,
+                       bool buildGlyphs = true) -> std::shared_ptr<ParagraphLayout>;
+
+  // Rasterizes every glyph that laying out `samples` with each typography would need, in parallel
+  // and outside the registry lock, then merges them into the glyph cache and atlases. Meant for
+  // loading screens so new scripts and sizes do not stall the first interactive frame.
+  void prewarmGlyphs(std::span<std::string_view const> samples,
+                     std::span<Typography const> typographies,
+                     float deviceScale = 1.0f);
+
   auto measureText(std::string_view text,
                    Typography const& typography) -> std::pair<int, int>;
 
+  // Measures every string under one lock with shared shaping state; same results as measureText.
+  auto measureTexts(std::span<std::string_view const> texts,
+                    Typography const& typography) -> std::vector<std::pair<int, int>>;
+
 private:
   struct Impl;
   std::unique_ptr<Impl> impl;
@@ -44,7 +88,15 @@ auto LayoutText(std::string_view text,
                 float deviceScale,
                 bool buildGlyphs = true) -> std::shared_ptr<TextRun>;
 
+auto LayoutParagraph(std::string_view text,
+                     Typography const& typography,
+                     float deviceScale,
+                     bool buildGlyphs = true) -> std::shared_ptr<ParagraphLayout>;
+
 auto MeasureText(std::string_view text,
                  Typography const& typography) -> std::pair<int, int>;
 
+auto MeasureTexts(std::span<std::string_view const> texts,
+                  Typography const& typography) -> std::vector<std::pair<int, int>>;
+
 } // namespace PrimeManifest
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 namespace PrimeManifest {
@@ -7,6 +8,42 @@ namespace PrimeManifest {
 enum class GlyphBitmapFormat : uint8_t {
   Mask8 = 0,
   ColorBGRA = 1,
+  Sdf8 = 2,
+};
+
+// Sdf8 glyphs are rasterized once at GlyphSdfReferenceSize pixels. Each byte stores the signed
+// distance to the outline as 128 + distance * 127 / GlyphSdfSpread (inside > 128), and the bitmap
+// is padded by GlyphSdfSpread pixels on every side.
+inline constexpr uint16_t GlyphSdfReferenceSize = 48;
+inline constexpr int32_t GlyphSdfSpread = 6;
+
+// Subpixel-positioned Mask8 glyphs are rasterized shifted right by subpixelBin / GlyphSubpixelBins pixels.
+inline constexpr uint8_t GlyphSubpixelBins = 4;
+
+// Exact source of a rasterized glyph: the FontRegistry that produced it (registry 0 means none)
+// and the face, size, glyph id and variant within it.
+struct GlyphIdentity {
+  uint64_t registry = 0;
+  uint32_t faceId = 0;
+  uint32_t glyphId = 0;
+  uint16_t sizePx = 0;
+  uint16_t embolden = 0;
+  uint8_t subpixelBin = 0;
+  bool distanceField = false;
+
+  bool operator==(GlyphIdentity const& other) const = default;
+};
+
+struct GlyphIdentityHash {
+  size_t operator()(GlyphIdentity const& id) const {
+    constexpr uint64_t Prime = 1099511628211ull;
+    uint64_t h = 1469598103934665603ull;
+    for (uint64_t v : {id.registry, uint64_t{id.faceId}, uint64_t{id.glyphId}, uint64_t{id.sizePx},
+                       uint64_t{id.embolden}, (uint64_t{id.subpixelBin} << 1) | (id.distanceField ? 1u : 0u)}) {
+      h = (h ^ v) * Prime;
+    }
+    return static_cast<size_t>(h);
+  }
 };
 
 } // namespace PrimeManifest
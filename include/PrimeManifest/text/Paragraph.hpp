@@ -0,0 +1,40 @@
+#pragma once
+
+#include "PrimeManifest/text/TextLayout.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace PrimeManifest {
+
+inline constexpr uint8_t ParagraphGlyphBreakAllowed = 1u << 0;
+inline constexpr uint8_t ParagraphGlyphBreakMandatory = 1u << 1;
+inline constexpr uint8_t ParagraphGlyphSpace = 1u << 2;
+inline constexpr uint8_t ParagraphGlyphNewline = 1u << 3;
+
+struct TextLineBreak {
+  uint32_t byteOffset = 0;
+  bool mandatory = false;
+};
+
+// A paragraph shaped once as a single run. Break opportunities are resolved per glyph, so
+// WrapParagraph can re-wrap to any width from the cached advances without reshaping.
+struct ParagraphLayout {
+  std::shared_ptr<TextRun> run;
+  std::vector<TextLineBreak> breaks;
+  std::vector<uint8_t> glyphFlags;
+};
+
+// Line break opportunities following a subset of UAX #14: mandatory breaks, breaks after
+// spaces, zero-width spaces and hyphens, and around ideographs. Offsets mark where a new line may start.
+auto FindLineBreaks(std::string_view text) -> std::vector<TextLineBreak>;
+
+auto BuildParagraphLayout(std::string_view text, std::shared_ptr<TextRun> run) -> ParagraphLayout;
+
+// Greedy wrap to maxWidth in layout units (maxWidth <= 0 only honours mandatory breaks).
+// Each line is returned as its own run with glyph positions relative to the line start.
+auto WrapParagraph(ParagraphLayout const& paragraph, float maxWidth) -> std::vector<TextRun>;
+
+} // namespace PrimeManifest
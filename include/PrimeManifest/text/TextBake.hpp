@@ -14,6 +14,9 @@ struct TextBakeResult {
   uint32_t runIndex = 0;
 };
 
+// Flagging the entry TextFlagSprite also builds the run's coverage sprite (BuildTextRunSprite).
+// Runs with a non-zero contentHash are baked once per batch: while batch.runs and the glyph
+// placements are kept across frames, re-appending the same run only pushes a text entry.
 auto AppendTextRun(RenderBatch& batch,
                    TextRun const& run,
                    int32_t x,
@@ -22,6 +25,23 @@ auto AppendTextRun(RenderBatch& batch,
                    uint8_t opacity = 255,
                    uint8_t flags = 0) -> std::optional<TextBakeResult>;
 
+// Drops runs that were neither appended since the last call nor referenced by a text entry,
+// together with their glyph placements, sprites and any bitmaps no remaining run uses, and
+// renumbers what is left. Call once per frame after appending text when batch.runs and glyph
+// placements are kept across frames, so retained text stores stay bounded. Returns the number
+// of runs dropped.
+auto TrimTextRuns(RenderBatch& batch) -> size_t;
+
+// Replaces a dense Mask8 bitmap's pixels with span-encoded rows so the text kernel skips empty
+// runs, fills full-coverage runs and only blends anti-aliased bytes. AppendTextRun applies it
+// to new bitmaps when batch.glyphs.encodeMaskSpans is set.
+auto EncodeGlyphMaskSpans(GlyphStore::GlyphBitmap& bitmap) -> bool;
+
+// Composites every Mask8 glyph of a run into batch.runs.sprites once, so text entries flagged
+// TextFlagSprite render as a single masked blit. Runs with SDF or colour glyphs keep the per-glyph
+// path and return false.
+auto BuildTextRunSprite(RenderBatch& batch, uint32_t runIndex) -> bool;
+
 auto AppendText(RenderBatch& batch,
                 std::string_view text,
                 Typography const& typography,
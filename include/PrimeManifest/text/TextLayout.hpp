@@ -21,6 +21,9 @@ struct GlyphBitmap {
   int32_t advance = 0;
   int32_t stride = 0;
   GlyphBitmapFormat format = GlyphBitmapFormat::Mask8;
+  uint8_t subpixelBin = 0;
+  // Set for bitmaps from a FontRegistry cache; left empty (registry 0) for caller-owned bitmaps.
+  GlyphIdentity identity{};
   std::vector<uint8_t> pixels;
   std::shared_ptr<GlyphAtlas> atlas;
   int32_t atlasX = 0;
@@ -52,6 +55,7 @@ struct TextRun {
   float height = 0.0f;
   float baseline = 0.0f;
   float layoutScale = 1.0f;
+  float glyphScale = 1.0f;
   uint64_t contentHash = 0;
 };
 
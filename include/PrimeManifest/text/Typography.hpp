@@ -28,6 +28,8 @@ struct Typography {
   std::string features;
   std::string locale;
   FontFallbackPolicy fallback = FontFallbackPolicy::BundleThenOS;
+  bool distanceField = false;
+  bool subpixelPositioning = false;
 };
 
 auto ToString(FontSlant slant) -> std::string_view;
@@ -0,0 +1,222 @@
+#include "PrimeManifest/renderer/Autotuner.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+
+namespace PrimeManifest {
+
+namespace {
+
+constexpr uint8_t TuningMagic[8] = {'P','M','T','U','N','E','\0','\0'};
+constexpr uint32_t TuningVersion = 1;
+constexpr uint16_t DefaultCandidateTileSizes[] = {8, 16, 32, 64};
+
+auto bucket(uint64_t value) -> uint8_t {
+  return static_cast<uint8_t>(std::bit_width(value));
+}
+
+} // namespace
+
+RenderAutotuner::RenderAutotuner() {
+  setCandidateTileSizes(DefaultCandidateTileSizes);
+}
+
+void RenderAutotuner::setCandidateTileSizes(std::span<uint16_t const> sizes) {
+  candidates_.clear();
+  for (uint16_t size : sizes) {
+    if (size == 0) continue;
+    candidates_.push_back(RenderTuning{size, true});
+    candidates_.push_back(RenderTuning{size, false});
+  }
+  if (candidates_.empty()) {
+    candidates_.push_back(RenderTuning{});
+  }
+  scenes_.clear();
+  pending_ = false;
+}
+
+void RenderAutotuner::setSampleFrames(uint32_t frames) {
+  sampleFrames_ = std::max(frames, 1u);
+}
+
+auto RenderAutotuner::sceneSignature(RenderBatch const& batch, uint32_t targetWidth, uint32_t targetHeight)
+    -> uint64_t {
+  std::array<uint64_t, RendererProfileCommandTypeBuckets> byType{};
+  for (auto const& cmd : batch.commands) {
+    size_t typeIndex = static_cast<size_t>(cmd.type);
+    if (typeIndex < byType.size()) {
+      ++byType[typeIndex];
+    }
+  }
+  uint64_t drawCount = 0;
+  for (size_t typeIndex = 0; typeIndex < byType.size(); ++typeIndex) {
+    CommandType type = static_cast<CommandType>(typeIndex);
+    if (type != CommandType::Clear && type != CommandType::ClearPattern && type != CommandType::DebugTiles) {
+      drawCount += byType[typeIndex];
+    }
+  }
+  uint64_t pixels = std::max<uint64_t>(uint64_t(targetWidth) * targetHeight, 1u);
+  uint64_t density = drawCount * 1000000u / pixels;
+
+  uint64_t hash = 1469598103934665603ull;
+  auto mix = [&](uint8_t value) { hash = (hash ^ value) * 1099511628211ull; };
+  for (uint64_t count : byType) {
+    mix(bucket(count));
+  }
+  mix(bucket(density));
+  mix(bucket(targetWidth));
+  mix(bucket(targetHeight));
+  return hash;
+}
+
+void RenderAutotuner::apply(RenderBatch& batch, uint32_t targetWidth, uint32_t targetHeight) {
+  pendingSignature_ = sceneSignature(batch, targetWidth, targetHeight);
+  Scene& scene = scenes_[pendingSignature_];
+  if (scene.settled) {
+    batch.tileSize = scene.choice.tileSize;
+    batch.autoTileStream = scene.choice.autoTileStream;
+    pending_ = false;
+    return;
+  }
+  if (scene.bestNs.size() != candidates_.size()) {
+    scene.bestNs.assign(candidates_.size(), std::numeric_limits<uint64_t>::max());
+    scene.candidate = 0;
+    scene.frames = 0;
+  }
+  RenderTuning const& tuning = candidates_[scene.candidate];
+  batch.tileSize = tuning.tileSize;
+  batch.autoTileStream = tuning.autoTileStream;
+  restoreReuse_ = batch.reuseOptimized;
+  batch.reuseOptimized = false;
+  restoreProfile_ = batch.profile == nullptr;
+  if (restoreProfile_) {
+    batch.profile = &profile_;
+  }
+  pending_ = true;
+}
+
+void RenderAutotuner::record(RenderBatch& batch) {
+  if (!pending_) return;
+  pending_ = false;
+  uint64_t ns = 0;
+  if (batch.profile) {
+    ns = batch.profile->renderNs + (restoreReuse_ ? 0u : batch.profile->buildNs);
+  }
+  batch.reuseOptimized = restoreReuse_;
+  if (restoreProfile_) {
+    batch.profile = nullptr;
+  }
+  auto it = scenes_.find(pendingSignature_);
+  if (it == scenes_.end() || it->second.settled || ns == 0) return;
+
+  Scene& scene = it->second;
+  scene.bestNs[scene.candidate] = std::min(scene.bestNs[scene.candidate], ns);
+  if (++scene.frames < sampleFrames_) return;
+  scene.frames = 0;
+  if (++scene.candidate < candidates_.size()) return;
+
+  auto best = std::min_element(scene.bestNs.begin(), scene.bestNs.end());
+  scene.choice = candidates_[static_cast<size_t>(best - scene.bestNs.begin())];
+  scene.settled = true;
+  scene.bestNs.clear();
+}
+
+auto RenderAutotuner::settled(RenderBatch const& batch, uint32_t targetWidth, uint32_t targetHeight) const
+    -> std::optional<RenderTuning> {
+  auto it = scenes_.find(sceneSignature(batch, targetWidth, targetHeight));
+  if (it == scenes_.end() || !it->second.settled) return std::nullopt;
+  return it->second.choice;
+}
+
+auto RenderAutotuner::settledCount() const -> size_t {
+  return static_cast<size_t>(std::count_if(scenes_.begin(), scenes_.end(),
+                                           [](auto const& entry) { return entry.second.settled; }));
+}
+
+auto RenderAutotuner::load(std::string const& path) -> bool {
+  std::ifstream input(path, std::ios::binary);
+  if (!input.is_open()) return false;
+  std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+  if (bytes.size() < 16 || std::memcmp(bytes.data(), TuningMagic, sizeof(TuningMagic)) != 0) {
+    return false;
+  }
+
+  size_t cursor = sizeof(TuningMagic);
+  auto read = [&](void* out, size_t size) -> bool {
+    if (cursor + size > bytes.size()) return false;
+    std::memcpy(out, bytes.data() + cursor, size);
+    cursor += size;
+    return true;
+  };
+
+  uint32_t version = 0;
+  uint32_t count = 0;
+  if (!read(&version, sizeof(version)) || !read(&count, sizeof(count))) return false;
+  if (version != TuningVersion) return false;
+
+  std::vector<std::pair<uint64_t, RenderTuning>> entries;
+  entries.reserve(std::min<size_t>(count, bytes.size() / 11));
+  for (uint32_t i = 0; i < count; ++i) {
+    uint64_t signature = 0;
+    RenderTuning tuning;
+    uint8_t autoTileStream = 0;
+    if (!read(&signature, sizeof(signature)) ||
+        !read(&tuning.tileSize, sizeof(tuning.tileSize)) ||
+        !read(&autoTileStream, sizeof(autoTileStream))) {
+      return false;
+    }
+    if (tuning.tileSize == 0) return false;
+    tuning.autoTileStream = autoTileStream != 0;
+    entries.emplace_back(signature, tuning);
+  }
+  for (auto const& [signature, tuning] : entries) {
+    Scene& scene = scenes_[signature];
+    scene = Scene{};
+    scene.settled = true;
+    scene.choice = tuning;
+  }
+  return true;
+}
+
+auto RenderAutotuner::save(std::string const& path) const -> bool {
+  std::filesystem::path target(path);
+  std::error_code ec;
+  if (target.has_parent_path()) {
+    std::filesystem::create_directories(target.parent_path(), ec);
+  }
+  std::filesystem::path temp = target;
+  temp += ".tmp";
+  {
+    std::ofstream output(temp, std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) return false;
+    auto write = [&](const void* data, size_t size) {
+      output.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+    };
+    uint32_t count = static_cast<uint32_t>(settledCount());
+    write(TuningMagic, sizeof(TuningMagic));
+    write(&TuningVersion, sizeof(TuningVersion));
+    write(&count, sizeof(count));
+    for (auto const& [signature, scene] : scenes_) {
+      if (!scene.settled) continue;
+      uint8_t autoTileStream = scene.choice.autoTileStream ? 1u : 0u;
+      write(&signature, sizeof(signature));
+      write(&scene.choice.tileSize, sizeof(scene.choice.tileSize));
+      write(&autoTileStream, sizeof(autoTileStream));
+    }
+    if (!output) return false;
+  }
+  std::filesystem::rename(temp, target, ec);
+  if (ec) {
+    std::filesystem::remove(temp, ec);
+    return false;
+  }
+  return true;
+}
+
+} // namespace PrimeManifest
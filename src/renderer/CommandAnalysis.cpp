@@ -323,7 +323,16 @@ void analyzeCommands(RenderBatch const& batch,
                      CommandAnalysisConfig const& config,
                      std::vector<AnalyzedCommand>& out) {
   out.assign(batch.commands.size(), AnalyzedCommand{});
-  for (uint32_t order = 0; order < batch.commands.size(); ++order) {
+  analyzeCommandRange(batch, config, 0, static_cast<uint32_t>(batch.commands.size()), out);
+}
+
+void analyzeCommandRange(RenderBatch const& batch,
+                         CommandAnalysisConfig const& config,
+                         uint32_t begin,
+                         uint32_t end,
+                         std::vector<AnalyzedCommand>& out) {
+  end = std::min<uint32_t>(end, static_cast<uint32_t>(std::min(batch.commands.size(), out.size())));
+  for (uint32_t order = begin; order < end; ++order) {
     RenderCommand const& cmd = batch.commands[order];
     AnalyzedCommand analyzed{};
     analyzed.type = cmd.type;
@@ -23,6 +23,7 @@ enum class CommandAnalysisSkipReason : uint8_t {
   CulledByBounds = 2,
   CulledByAlpha = 3,
   UnsupportedCommandType = 4,
+  Coalesced = 5,
 };
 
 struct AnalyzedCommand {
@@ -64,4 +65,12 @@ void analyzeCommands(RenderBatch const& batch,
                      CommandAnalysisConfig const& config,
                      std::vector<AnalyzedCommand>& out);
 
+// Analyzes commands [begin, end) into the same slots of `out`, which must already hold one entry
+// per command. Disjoint ranges touch disjoint slots and may run concurrently.
+void analyzeCommandRange(RenderBatch const& batch,
+                         CommandAnalysisConfig const& config,
+                         uint32_t begin,
+                         uint32_t end,
+                         std::vector<AnalyzedCommand>& out);
+
 } // namespace PrimeManifest
@@ -8,6 +8,7 @@
 #include <condition_variable>
 #include <cstdint>
 #include <functional>
+#include <limits>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -18,6 +19,13 @@ namespace PrimeManifest {
 namespace {
 
 constexpr uint32_t MacroFactor = 2;
+constexpr uint32_t GlyphSpanMinGlyphs = 16;
+constexpr uint32_t kParallelCommandBinningThreshold = 8192;
+constexpr uint32_t kParallelCacheThreshold = 2048;
+constexpr uint32_t kLargeCommandTiles = 16;
+constexpr uint32_t kMinSubTileSize = 8;
+constexpr uint32_t kMaxMergedTiles = 32;
+constexpr uint64_t kSplitCostFloor = 64ull * 32ull * 32ull;
 
 struct BinningPool {
   std::mutex mutex;
@@ -95,6 +103,43 @@ auto binning_pool() -> BinningPool& {
   return pool;
 }
 
+// Runs fn(begin, end) over one contiguous slice of [0, count) per pool thread, or inline when
+// the range is below minCount.
+template <typename Fn>
+void parallel_slices(uint32_t count, uint32_t minCount, Fn&& fn) {
+  auto& pool = binning_pool();
+  uint32_t threadCount = std::min<uint32_t>(std::max(1u, pool.thread_count()), std::max(1u, count));
+  if (threadCount <= 1 || count < minCount) {
+    fn(0u, count);
+    return;
+  }
+  uint32_t chunk = (count + threadCount - 1u) / threadCount;
+  pool.run([&](uint32_t t) {
+    if (t >= threadCount) return;
+    uint32_t begin = t * chunk;
+    uint32_t end = std::min(begin + chunk, count);
+    if (begin < end) {
+      fn(begin, end);
+    }
+  });
+}
+
+// Each slice writes its own AnalyzedCommand slots, so the output keeps command order.
+void analyze_commands_parallel(RenderBatch const& batch,
+                               CommandAnalysisConfig const& config,
+                               std::vector<AnalyzedCommand>& out) {
+  constexpr uint32_t kParallelAnalysisThreshold = 4096u;
+  uint32_t commandCount = static_cast<uint32_t>(batch.commands.size());
+  if (commandCount < kParallelAnalysisThreshold) {
+    analyzeCommands(batch, config, out);
+    return;
+  }
+  out.resize(commandCount);
+  parallel_slices(commandCount, kParallelAnalysisThreshold, [&](uint32_t begin, uint32_t end) {
+    analyzeCommandRange(batch, config, begin, end, out);
+  });
+}
+
 struct Vec2f {
   float x = 0.0f;
   float y = 0.0f;
@@ -120,6 +165,68 @@ auto apply_opacity(uint8_t a, uint8_t opacity) -> uint8_t {
   return static_cast<uint8_t>(std::min<uint16_t>(v, 255u));
 }
 
+// Appends conservative text-origin-relative x spans for a run's glyphs: left edges plus a running
+// maximum of right edges. Fails (and appends nothing) for short runs or left edges that go back.
+auto append_glyph_spans(RenderBatch const& batch,
+                        uint32_t runIndex,
+                        std::vector<int32_t>& spanX0,
+                        std::vector<int32_t>& spanMaxX1) -> bool {
+  if (runIndex >= batch.runs.glyphStart.size() ||
+      runIndex >= batch.runs.glyphCount.size() ||
+      runIndex >= batch.runs.scaleQ8_8.size()) {
+    return false;
+  }
+  uint32_t glyphStart = batch.runs.glyphStart[runIndex];
+  uint32_t glyphCount = batch.runs.glyphCount[runIndex];
+  uint32_t glyphEnd = glyphStart + glyphCount;
+  if (glyphCount < GlyphSpanMinGlyphs ||
+      glyphEnd > batch.glyphs.glyphXQ8_8.size() ||
+      glyphEnd > batch.glyphs.bitmapIndex.size()) {
+    return false;
+  }
+  float scale = static_cast<float>(batch.runs.scaleQ8_8[runIndex]) / 256.0f;
+  float glyphScale = 1.0f;
+  if (runIndex < batch.runs.glyphScaleQ8_8.size() && batch.runs.glyphScaleQ8_8[runIndex] != 0u) {
+    glyphScale = static_cast<float>(batch.runs.glyphScaleQ8_8[runIndex]) / 256.0f;
+  }
+
+  size_t base = spanX0.size();
+  int32_t left = std::numeric_limits<int32_t>::min();
+  int32_t maxRight = std::numeric_limits<int32_t>::min();
+  for (uint32_t gi = glyphStart; gi < glyphEnd; ++gi) {
+    uint32_t bitmapIndex = batch.glyphs.bitmapIndex[gi];
+    if (bitmapIndex < batch.glyphs.bitmaps.size()) {
+      auto const& bmp = batch.glyphs.bitmaps[bitmapIndex];
+      if (bmp.width > 0 && bmp.height > 0) {
+        float gx = static_cast<float>(batch.glyphs.glyphXQ8_8[gi]) / 256.0f * scale;
+        float x0 = 0.0f;
+        float x1 = 0.0f;
+        if (bmp.format == GlyphBitmapFormat::Sdf8) {
+          x0 = gx + static_cast<float>(bmp.bearingX) * glyphScale;
+          x1 = x0 + static_cast<float>(bmp.width) * glyphScale;
+        } else {
+          x0 = gx + static_cast<float>(bmp.bearingX) -
+               static_cast<float>(bmp.subpixelBin) / static_cast<float>(GlyphSubpixelBins);
+          x1 = x0 + static_cast<float>(bmp.width);
+        }
+        // One pixel of slack on each side covers the kernel's lround/floor/ceil snapping.
+        int32_t glyphLeft = static_cast<int32_t>(std::floor(x0)) - 1;
+        int32_t glyphRight = static_cast<int32_t>(std::ceil(x1)) + 1;
+        if (glyphLeft < left) {
+          spanX0.resize(base);
+          spanMaxX1.resize(base);
+          return false;
+        }
+        left = glyphLeft;
+        maxRight = std::max(maxRight, glyphRight);
+      }
+    }
+    spanX0.push_back(left);
+    spanMaxX1.push_back(maxRight);
+  }
+  return true;
+}
+
 auto count_command_types(RenderBatch const& batch) -> CommandTypeCounts {
   CommandTypeCounts counts{};
   for (auto const& cmd : batch.commands) {
@@ -202,6 +309,7 @@ auto mapOptimizerSkipReason(CommandAnalysisSkipReason reason, SkippedCommandReas
       return true;
     case CommandAnalysisSkipReason::None:
     case CommandAnalysisSkipReason::UnsupportedCommandType:
+    case CommandAnalysisSkipReason::Coalesced:
       return false;
   }
   return false;
@@ -279,6 +387,306 @@ auto make_tile_grid(uint32_t width, uint32_t height, uint32_t tileSize) -> TileG
   return grid;
 }
 
+// Position of a command in its tile bin: zKeys (empty unless sorting by z) take precedence over
+// command order.
+auto draw_key(std::vector<uint16_t> const& zKeys, uint32_t cmdIndex) -> uint64_t {
+  uint64_t z = cmdIndex < zKeys.size() ? zKeys[cmdIndex] : 0u;
+  return (z << 32) | cmdIndex;
+}
+
+// Per-command 16-bit z keys ordered the way bins are consumed: ascending for painter's order,
+// descending when the first command in a bin is the frontmost.
+void build_z_keys(RenderBatch const& batch, bool frontToBack, std::vector<uint16_t>& zKeys) {
+  uint32_t commandCount = static_cast<uint32_t>(batch.commands.size());
+  zKeys.resize(commandCount);
+  auto key_of = [](int16_t z, bool invert) -> uint16_t {
+    uint16_t key = static_cast<uint16_t>(static_cast<uint16_t>(z) ^ 0x8000u);
+    return invert ? static_cast<uint16_t>(0xFFFFu - key) : key;
+  };
+  parallel_slices(commandCount, 4096u, [&](uint32_t begin, uint32_t end) {
+    for (uint32_t i = begin; i < end; ++i) {
+      auto const& cmd = batch.commands[i];
+      int16_t z = 0;
+      if (cmd.type == CommandType::Rect && cmd.index < batch.rects.zQ8_8.size()) {
+        z = batch.rects.zQ8_8[cmd.index];
+      } else if (cmd.type == CommandType::Text && cmd.index < batch.text.zQ8_8.size()) {
+        z = batch.text.zQ8_8[cmd.index];
+      }
+      zKeys[i] = key_of(z, frontToBack);
+    }
+  });
+}
+
+// Stable sort of one bin's command refs by z key: insertion sort for short bins, otherwise two
+// 8-bit LSD counting passes through `scratch`.
+void sort_tile_refs_by_z(uint32_t* refs,
+                         uint32_t count,
+                         std::vector<uint16_t> const& zKeys,
+                         std::vector<uint32_t>& scratch) {
+  constexpr uint32_t kInsertionSortMax = 32;
+  if (count < 2) return;
+  bool sorted = true;
+  for (uint32_t i = 1; i < count && sorted; ++i) {
+    sorted = zKeys[refs[i - 1]] <= zKeys[refs[i]];
+  }
+  if (sorted) return;
+  if (count <= kInsertionSortMax) {
+    for (uint32_t i = 1; i < count; ++i) {
+      uint32_t ref = refs[i];
+      uint16_t key = zKeys[ref];
+      uint32_t j = i;
+      while (j > 0 && zKeys[refs[j - 1]] > key) {
+        refs[j] = refs[j - 1];
+        --j;
+      }
+      refs[j] = ref;
+    }
+    return;
+  }
+  scratch.resize(count);
+  uint32_t* src = refs;
+  uint32_t* dst = scratch.data();
+  for (uint32_t shift = 0; shift < 16; shift += 8) {
+    uint32_t histogram[256] = {};
+    for (uint32_t i = 0; i < count; ++i) {
+      ++histogram[(zKeys[src[i]] >> shift) & 0xFFu];
+    }
+    uint32_t offset = 0;
+    for (uint32_t& bucket : histogram) {
+      uint32_t n = bucket;
+      bucket = offset;
+      offset += n;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+      dst[histogram[(zKeys[src[i]] >> shift) & 0xFFu]++] = src[i];
+    }
+    std::swap(src, dst);
+  }
+}
+
+// Marks, per tile, the draw key of the command that paints the whole tile with an opaque
+// axis-aligned rect and hides everything drawn before it (after it, when commands are
+// front-to-back). Tiles without such a rect keep the sentinel, 0 or UINT64_MAX. Returns false when
+// no tile is fully covered.
+auto compute_tile_occluders(RenderBatch const& batch,
+                            std::vector<AnalyzedCommand> const& analyzedCommands,
+                            std::vector<uint16_t> const& zKeys,
+                            TileGrid const& grid,
+                            uint32_t targetWidth,
+                            uint32_t targetHeight,
+                            bool frontToBack,
+                            std::vector<uint64_t>& occluders) -> bool {
+  if (batch.disableOpaqueRectFastPath || grid.tilesX == 0 || grid.tilesY == 0) return false;
+  bool any = false;
+  int32_t maxX = static_cast<int32_t>(targetWidth);
+  int32_t maxY = static_cast<int32_t>(targetHeight);
+  int32_t tileSize = static_cast<int32_t>(grid.tileSize);
+  uint32_t commandCount = static_cast<uint32_t>(analyzedCommands.size());
+  for (uint32_t i = 0; i < commandCount; ++i) {
+    auto const& analyzed = analyzedCommands[i];
+    if (!analyzed.valid || analyzed.type != CommandType::Rect || analyzed.baseAlpha != 255u) continue;
+    uint32_t idx = analyzed.index;
+    uint8_t flags = idx < batch.rects.flags.size() ? batch.rects.flags[idx] : 0u;
+    if ((flags & (RectFlagGradient | RectFlagSmoothBlend)) != 0u) continue;
+    if (idx < batch.rects.radiusQ8_8.size() && batch.rects.radiusQ8_8[idx] != 0) continue;
+    if (idx < batch.rects.rotationQ8_8.size() && batch.rects.rotationQ8_8[idx] != 0) continue;
+    int32_t x0 = std::max<int32_t>(analyzed.x0, 0);
+    int32_t y0 = std::max<int32_t>(analyzed.y0, 0);
+    int32_t x1 = std::min<int32_t>(analyzed.x1, maxX);
+    int32_t y1 = std::min<int32_t>(analyzed.y1, maxY);
+    if (x1 <= x0 || y1 <= y0) continue;
+    // Fully covered tiles start at or after x0 and end at or before x1; the last column and row
+    // are clipped by the target edge.
+    int32_t ftx0 = (x0 + tileSize - 1) / tileSize;
+    int32_t fty0 = (y0 + tileSize - 1) / tileSize;
+    int32_t ftx1 = x1 >= maxX ? static_cast<int32_t>(grid.tilesX) : x1 / tileSize;
+    int32_t fty1 = y1 >= maxY ? static_cast<int32_t>(grid.tilesY) : y1 / tileSize;
+    if (ftx1 <= ftx0 || fty1 <= fty0) continue;
+    if (!any) {
+      occluders.assign(static_cast<size_t>(grid.tilesX) * grid.tilesY, frontToBack ? UINT64_MAX : 0u);
+      any = true;
+    }
+    uint64_t key = draw_key(zKeys, i);
+    for (int32_t ty = fty0; ty < fty1; ++ty) {
+      uint64_t* row = occluders.data() + static_cast<size_t>(ty) * grid.tilesX;
+      for (int32_t tx = ftx0; tx < ftx1; ++tx) {
+        row[tx] = frontToBack ? std::min(row[tx], key) : std::max(row[tx], key);
+      }
+    }
+  }
+  return any;
+}
+
+// Folds runs of consecutive commands that paint one axis-aligned block into the first command of
+// the run: abutting or overlapping same-colour opaque rects (same z, no radius, rotation, gradient,
+// clip or smooth blend) that grow the run along a row or a column, and SetPixels stepping right
+// by one pixel with the same colour. The leader takes the union bounds; the rest are marked
+// invalid. Returns the number of commands folded away; leaders are appended to `leaders`.
+auto coalesce_commands(RenderBatch const& batch,
+                       std::vector<uint16_t> const& zKeys,
+                       CommandAnalysisConfig const& config,
+                       std::vector<AnalyzedCommand>& analyzedCommands,
+                       std::vector<uint32_t>& leaders) -> uint32_t {
+  auto simple_rect = [&](AnalyzedCommand const& analyzed) -> bool {
+    if (!analyzed.valid || analyzed.type != CommandType::Rect || analyzed.baseAlpha != 255u) return false;
+    if (analyzed.clipEnabled) return false;
+    uint32_t idx = analyzed.index;
+    if (idx < batch.rects.flags.size() && batch.rects.flags[idx] != 0u) return false;
+    if (idx < batch.rects.radiusQ8_8.size() && batch.rects.radiusQ8_8[idx] != 0) return false;
+    if (idx < batch.rects.rotationQ8_8.size() && batch.rects.rotationQ8_8[idx] != 0) return false;
+    return true;
+  };
+  auto pixel = [&](AnalyzedCommand const& analyzed) -> bool {
+    return analyzed.valid && analyzed.type == CommandType::SetPixel;
+  };
+  auto same_z = [&](uint32_t a, uint32_t b) -> bool {
+    return zKeys.empty() || zKeys[a] == zKeys[b];
+  };
+  // Appends `next` to the block when the union stays a rectangle.
+  auto extends = [](AnalyzedCommand const& block, AnalyzedCommand const& next) -> bool {
+    if (next.y0 == block.y0 && next.y1 == block.y1) {
+      return next.x0 <= block.x1 && next.x1 >= block.x0;
+    }
+    if (next.x0 == block.x0 && next.x1 == block.x1) {
+      return next.y0 <= block.y1 && next.y1 >= block.y0;
+    }
+    return false;
+  };
+
+  bool rectsAllowed = !batch.disableOpaqueRectFastPath;
+  uint32_t folded = 0;
+  uint32_t commandCount = static_cast<uint32_t>(analyzedCommands.size());
+  uint32_t i = 0;
+  while (i < commandCount) {
+    AnalyzedCommand& leader = analyzedCommands[i];
+    bool isRect = rectsAllowed && simple_rect(leader);
+    bool isPixel = !isRect && pixel(leader);
+    uint32_t j = i + 1;
+    if (isRect) {
+      uint8_t color = batch.rects.colorIndex[leader.index];
+      while (j < commandCount) {
+        AnalyzedCommand& next = analyzedCommands[j];
+        if (!simple_rect(next) || batch.rects.colorIndex[next.index] != color || !same_z(i, j) ||
+            !extends(leader, next)) {
+          break;
+        }
+        leader.x0 = std::min(leader.x0, next.x0);
+        leader.y0 = std::min(leader.y0, next.y0);
+        leader.x1 = std::max(leader.x1, next.x1);
+        leader.y1 = std::max(leader.y1, next.y1);
+        ++j;
+      }
+    } else if (isPixel) {
+      uint8_t color = batch.pixels.colorIndex[leader.index];
+      while (j < commandCount) {
+        AnalyzedCommand const& next = analyzedCommands[j];
+        if (!pixel(next) || batch.pixels.colorIndex[next.index] != color ||
+            next.y0 != leader.y0 || next.x0 != leader.x1) {
+          break;
+        }
+        leader.x1 = next.x1;
+        ++j;
+      }
+    }
+    if (j > i + 1) {
+      uint32_t tileSize = config.tileSize == 0 ? 1u : config.tileSize;
+      if (config.tilePow2) {
+        leader.tx0 = static_cast<uint32_t>(leader.x0) >> config.tileShift;
+        leader.ty0 = static_cast<uint32_t>(leader.y0) >> config.tileShift;
+        leader.tx1 = static_cast<uint32_t>(leader.x1 - 1) >> config.tileShift;
+        leader.ty1 = static_cast<uint32_t>(leader.y1 - 1) >> config.tileShift;
+      } else {
+        leader.tx0 = static_cast<uint32_t>(leader.x0) / tileSize;
+        leader.ty0 = static_cast<uint32_t>(leader.y0) / tileSize;
+        leader.tx1 = static_cast<uint32_t>(leader.x1 - 1) / tileSize;
+        leader.ty1 = static_cast<uint32_t>(leader.y1 - 1) / tileSize;
+      }
+      for (uint32_t k = i + 1; k < j; ++k) {
+        analyzedCommands[k].valid = false;
+        analyzedCommands[k].skipReason = CommandAnalysisSkipReason::Coalesced;
+      }
+      leaders.push_back(i);
+      folded += j - i - 1u;
+    }
+    i = j;
+  }
+  return folded;
+}
+
+// Splits tiles whose estimated cost ((refs + 1) x area) exceeds the per-worker budget into 2x2 or
+// 4x4 sub-tiles, never below kMinSubTileSize pixels, and merges runs of cheap tiles into one job.
+// Jobs are ordered most expensive first so the pool drains the long ones early.
+void build_tile_work(std::vector<uint32_t> const& renderTiles,
+                     std::vector<uint32_t> const& tileLoad,
+                     uint32_t tileSize,
+                     uint32_t tilesX,
+                     uint32_t width,
+                     uint32_t height,
+                     uint32_t workerCount,
+                     std::vector<OptimizedBatch::TileWorkUnit>& out) {
+  out.clear();
+  size_t count = renderTiles.size();
+  if (count <= 2 || tilesX == 0) return;
+
+  std::vector<uint64_t> cost(count);
+  uint64_t total = 0;
+  for (size_t i = 0; i < count; ++i) {
+    uint32_t tile = renderTiles[i];
+    uint32_t x0 = (tile % tilesX) * tileSize;
+    uint32_t y0 = (tile / tilesX) * tileSize;
+    uint64_t area = static_cast<uint64_t>(std::min(x0 + tileSize, width) - x0) *
+                    static_cast<uint64_t>(std::min(y0 + tileSize, height) - y0);
+    uint64_t load = tile < tileLoad.size() ? tileLoad[tile] : 0u;
+    cost[i] = (load + 1u) * area;
+    total += cost[i];
+  }
+  uint64_t budget = std::max<uint64_t>(total / (std::max(workerCount, 1u) * 8ull), 1u);
+  uint64_t splitAt = std::max(budget, kSplitCostFloor);
+
+  std::vector<uint64_t> unitCost;
+  out.reserve(count);
+  unitCost.reserve(count);
+  size_t i = 0;
+  while (i < count) {
+    uint32_t split = 1;
+    while (split < 4 && tileSize / (split * 2u) >= kMinSubTileSize && cost[i] / (split * split) > splitAt) {
+      split *= 2u;
+    }
+    if (split > 1) {
+      uint32_t parts = split * split;
+      for (uint32_t part = 0; part < parts; ++part) {
+        out.push_back({static_cast<uint32_t>(i), 1u, static_cast<uint8_t>(split), static_cast<uint8_t>(part)});
+        unitCost.push_back(cost[i] / parts);
+      }
+      ++i;
+      continue;
+    }
+    OptimizedBatch::TileWorkUnit unit{static_cast<uint32_t>(i), 1u, 1u, 0u};
+    uint64_t merged = cost[i];
+    ++i;
+    while (i < count && unit.tileCount < kMaxMergedTiles && merged + cost[i] <= budget) {
+      merged += cost[i];
+      ++unit.tileCount;
+      ++i;
+    }
+    out.push_back(unit);
+    unitCost.push_back(merged);
+  }
+
+  std::vector<uint32_t> order(out.size());
+  for (uint32_t k = 0; k < order.size(); ++k) {
+    order[k] = k;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return unitCost[a] > unitCost[b];
+  });
+  std::vector<OptimizedBatch::TileWorkUnit> sorted(out.size());
+  for (size_t k = 0; k < order.size(); ++k) {
+    sorted[k] = out[order[k]];
+  }
+  out.swap(sorted);
+}
+
 auto command_type_name(CommandType type) -> const char* {
   switch (type) {
     case CommandType::Clear:
@@ -847,15 +1255,19 @@ auto optimize_batch(RenderTarget target,
         out.hasClear = true;
         out.clearPattern = false;
       }
-    } else {
+    } else if (commandCounts.clearCount + commandCounts.clearPattern > 0) {
+      uint32_t clearsLeft = commandCounts.clearCount + commandCounts.clearPattern;
       for (auto const& cmd : batch.commands) {
+        if (clearsLeft == 0) break;
         if (cmd.type == CommandType::Clear) {
+          --clearsLeft;
           if (cmd.index < batch.clear.colorIndex.size()) {
             out.clearColor = fetch_color(batch.clear.colorIndex, cmd.index, out.clearColor);
             out.hasClear = true;
             out.clearPattern = false;
           }
         } else if (cmd.type == CommandType::ClearPattern) {
+          --clearsLeft;
           if (cmd.index < batch.clearPattern.width.size() &&
               cmd.index < batch.clearPattern.height.size() &&
               cmd.index < batch.clearPattern.dataOffset.size()) {
@@ -879,8 +1291,11 @@ auto optimize_batch(RenderTarget target,
     }
 
     if (commandCounts.debugTiles > 0) {
+      uint32_t debugLeft = commandCounts.debugTiles;
       for (auto const& cmd : batch.commands) {
+        if (debugLeft == 0) break;
         if (cmd.type != CommandType::DebugTiles) continue;
+        --debugLeft;
         if (cmd.index < batch.debugTiles.colorIndex.size()) {
           out.debugColor = fetch_color(batch.debugTiles.colorIndex, cmd.index, out.debugColor);
           out.debugTiles = true;
@@ -1074,6 +1489,7 @@ auto optimize_batch(RenderTarget target,
   auto& tileRefs = prepared.tileRefs;
   auto& tileFill = prepared.tileFill;
   auto& renderTiles = prepared.renderTiles;
+  auto& largeRefs = prepared.largeRefs;
   auto& textBaseAlpha = prepared.textBaseAlpha;
   auto& textActive = prepared.textActive;
   auto& textPmOffset = prepared.textPmOffset;
@@ -1089,6 +1505,10 @@ auto optimize_batch(RenderTarget target,
   auto& textClipY0 = prepared.textClipY0;
   auto& textClipX1 = prepared.textClipX1;
   auto& textClipY1 = prepared.textClipY1;
+  auto& textRunSpanOffset = prepared.textRunSpanOffset;
+  auto& textGlyphSpanX0 = prepared.textGlyphSpanX0;
+  auto& textGlyphSpanMaxX1 = prepared.textGlyphSpanMaxX1;
+  auto& rectRecords = prepared.rectRecords;
   auto& rectBaseAlpha = prepared.rectBaseAlpha;
   auto& rectActive = prepared.rectActive;
   auto& rectEdgeOffset = prepared.rectEdgeOffset;
@@ -1114,6 +1534,8 @@ auto optimize_batch(RenderTarget target,
   auto& rectGradMin = prepared.rectGradMin;
   auto& rectGradInvRange = prepared.rectGradInvRange;
   constexpr uint32_t InvalidOffset = 0xFFFFFFFFu;
+  constexpr uint32_t RunSpanUnbuilt = 0xFFFFFFFEu;
+  constexpr uint32_t NeedsPmLut = 0xFFFFFFFEu;
 
   if (hasDraw) {
     renderTiles.clear();
@@ -1125,7 +1547,11 @@ auto optimize_batch(RenderTarget target,
     rectEdgePmBStore.clear();
 
     size_t rectCount = std::min(batch.rects.colorIndex.size(), batch.rects.opacity.size());
+    rectRecords.clear();
     if (rectCount > 0) {
+      if (batch.packRectRecords) {
+        rectRecords.resize(rectCount);
+      }
       rectBaseAlpha.assign(rectCount, 0);
       rectActive.assign(rectCount, 0);
       rectEdgeOffset.assign(rectCount, InvalidOffset);
@@ -1163,6 +1589,9 @@ auto optimize_batch(RenderTarget target,
       textClipX1.assign(textCount, 0);
       textClipY1.assign(textCount, 0);
     }
+    textRunSpanOffset.clear();
+    textGlyphSpanX0.clear();
+    textGlyphSpanMaxX1.clear();
     auto runRenderTileSelectionStage = [&](bool fromTileStream) {
       auto renderTilesStart = profile ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
       renderTiles.clear();
@@ -1182,8 +1611,18 @@ auto optimize_batch(RenderTarget target,
           if (tileMask[i]) renderTiles.push_back(i);
         }
       } else {
+        std::vector<uint8_t> largeMask;
+        if (!largeRefs.empty()) {
+          largeMask.assign(tileCount, 0);
+          for (uint32_t cmdIndex : largeRefs) {
+            auto const& info = cmdTiles[cmdIndex];
+            for (uint32_t ty = info.ty0; ty <= info.ty1; ++ty) {
+              std::fill_n(largeMask.begin() + ty * grid.tilesX + info.tx0, info.tx1 - info.tx0 + 1u, uint8_t{1});
+            }
+          }
+        }
         for (uint32_t i = 0; i < tileCount; ++i) {
-          if (tileCounts[i] > 0) {
+          if (tileCounts[i] > 0 || (!largeMask.empty() && largeMask[i] != 0)) {
             renderTiles.push_back(i);
           }
         }
@@ -1232,7 +1671,7 @@ auto optimize_batch(RenderTarget target,
             analysisConfig.tileShift = tileShift;
             analysisConfig.paletteOpaque = paletteOpaque;
             std::vector<AnalyzedCommand> analyzedCommands;
-            analyzeCommands(batch, analysisConfig, analyzedCommands);
+            analyze_commands_parallel(batch, analysisConfig, analyzedCommands);
             recordAnalyzedSkips(analyzedCommands);
           }
           size_t circleCount = std::min({batch.circles.centerX.size(),
@@ -1573,50 +2012,177 @@ auto optimize_batch(RenderTarget target,
         analysisConfig.paletteOpaque = paletteOpaque;
 
         std::vector<AnalyzedCommand> analyzedCommands;
-        analyzeCommands(batch, analysisConfig, analyzedCommands);
+        analyze_commands_parallel(batch, analysisConfig, analyzedCommands);
         recordAnalyzedSkips(analyzedCommands);
 
-        for (uint32_t i = 0; i < analyzedCommands.size(); ++i) {
-          auto const& analyzed = analyzedCommands[i];
-          if (!analyzed.valid) continue;
+        // Commands hidden behind an opaque tile-covering rect are left out of that tile's refs; a
+        // command hidden in every tile it touches is dropped altogether.
+        bool frontToBackBins = batch.assumeFrontToBack && (useTileBuffer || allowAutoTileStream);
+        std::vector<uint16_t> zKeys;
+        if (batch.sortByZ) {
+          build_z_keys(batch, frontToBackBins, zKeys);
+        }
+        uint32_t coalesced = coalesce_commands(batch, zKeys, analysisConfig, analyzedCommands,
+                                               prepared.coalescedCommands);
+        if (profile) {
+          profile->coalescedCommandCount = coalesced;
+        }
+        std::vector<uint64_t> occluders;
+        bool hasOccluders = compute_tile_occluders(batch, analyzedCommands, zKeys, grid, target.width, target.height,
+                                                   frontToBackBins, occluders);
+        auto visible_in_tile = [&](uint32_t cmdIndex, uint32_t tileIdx) -> bool {
+          if (!hasOccluders) return true;
+          uint64_t key = draw_key(zKeys, cmdIndex);
+          return frontToBackBins ? key <= occluders[tileIdx] : key >= occluders[tileIdx];
+        };
 
+        // Counts a command into the tiles it is visible in and returns whether it is visible at all.
+        // Commands spanning kLargeCommandTiles or more go to largeRefs instead of per-tile refs.
+        std::vector<uint8_t> cmdLarge(analyzedCommands.size(), 0);
+        auto count_command = [&](uint32_t i, std::vector<uint32_t>& counts) -> bool {
+          auto const& analyzed = analyzedCommands[i];
+          if (!analyzed.valid) return false;
+          uint32_t spanTiles = (analyzed.tx1 - analyzed.tx0 + 1u) * (analyzed.ty1 - analyzed.ty0 + 1u);
+          bool large = !useCircleRefs && spanTiles >= kLargeCommandTiles;
+          uint32_t binned = 0;
+          if (large && !hasOccluders) {
+            binned = spanTiles;
+          } else {
+            for (uint32_t ty = analyzed.ty0; ty <= analyzed.ty1; ++ty) {
+              for (uint32_t tx = analyzed.tx0; tx <= analyzed.tx1; ++tx) {
+                uint32_t tileIdx = ty * grid.tilesX + tx;
+                if (!visible_in_tile(i, tileIdx)) continue;
+                if (!large) {
+                  counts[tileIdx] += 1;
+                }
+                ++binned;
+              }
+            }
+          }
+          if (binned == 0) return false;
           cmdActive[i] = 1;
+          cmdLarge[i] = large ? 1u : 0u;
           cmdTiles[i] = OptimizedBatch::CmdTileInfo{
             analyzed.x0, analyzed.y0, analyzed.x1, analyzed.y1, analyzed.tx0, analyzed.ty0, analyzed.tx1, analyzed.ty1};
-          if (analyzed.type == CommandType::Rect && analyzed.index < rectActive.size()) {
-            rectActive[analyzed.index] = 1;
+          return true;
+        };
+
+        auto& pool = binning_pool();
+        uint32_t commandCount = static_cast<uint32_t>(analyzedCommands.size());
+        uint32_t threadCount = std::min<uint32_t>(std::max(1u, pool.thread_count()), std::max(1u, commandCount));
+        if (threadCount > 1 && commandCount >= kParallelCommandBinningThreshold) {
+          // Same two-pass scheme as bin_circles_parallel: per-thread tile histograms over contiguous
+          // command slices, then thread-major offsets inside each tile so refs stay in command order.
+          uint32_t chunk = (commandCount + threadCount - 1u) / threadCount;
+          std::vector<std::vector<uint32_t>> localCounts(threadCount, std::vector<uint32_t>(tileCount, 0));
+          pool.run([&](uint32_t t) {
+            if (t >= threadCount) return;
+            uint32_t start = t * chunk;
+            uint32_t end = std::min(start + chunk, commandCount);
+            auto& counts = localCounts[t];
+            for (uint32_t i = start; i < end; ++i) {
+              count_command(i, counts);
+            }
+          });
+          // Primitive-level flags are shared between commands that reuse an index; mark them serially.
+          for (uint32_t i = 0; i < commandCount; ++i) {
+            if (cmdActive[i] == 0) continue;
+            auto const& analyzed = analyzedCommands[i];
+            if (analyzed.type == CommandType::Rect && analyzed.index < rectActive.size()) {
+              rectActive[analyzed.index] = 1;
+            } else if (analyzed.type == CommandType::Text && analyzed.index < textActive.size()) {
+              textActive[analyzed.index] = 1;
+            }
           }
-          if (analyzed.type == CommandType::Text && analyzed.index < textActive.size()) {
-            textActive[analyzed.index] = 1;
+
+          tileOffsets.assign(tileCount + 1, 0);
+          std::vector<std::vector<uint32_t>> threadOffsets(threadCount, std::vector<uint32_t>(tileCount, 0));
+          for (uint32_t tile = 0; tile < tileCount; ++tile) {
+            uint32_t offset = tileOffsets[tile];
+            for (uint32_t t = 0; t < threadCount; ++t) {
+              threadOffsets[t][tile] = offset;
+              offset += localCounts[t][tile];
+            }
+            tileCounts[tile] = offset - tileOffsets[tile];
+            tileOffsets[tile + 1] = offset;
           }
-          for (uint32_t ty = analyzed.ty0; ty <= analyzed.ty1; ++ty) {
-            for (uint32_t tx = analyzed.tx0; tx <= analyzed.tx1; ++tx) {
-              tileCounts[ty * grid.tilesX + tx] += 1;
+          tileRefs.assign(tileOffsets.back(), 0);
+          pool.run([&](uint32_t t) {
+            if (t >= threadCount) return;
+            uint32_t start = t * chunk;
+            uint32_t end = std::min(start + chunk, commandCount);
+            auto& offsets = threadOffsets[t];
+            for (uint32_t i = start; i < end; ++i) {
+              if (cmdActive[i] == 0 || cmdLarge[i] != 0) continue;
+              auto const& info = cmdTiles[i];
+              for (uint32_t ty = info.ty0; ty <= info.ty1; ++ty) {
+                for (uint32_t tx = info.tx0; tx <= info.tx1; ++tx) {
+                  uint32_t tileIdx = ty * grid.tilesX + tx;
+                  if (!visible_in_tile(i, tileIdx)) continue;
+                  tileRefs[offsets[tileIdx]++] = i;
+                }
+              }
+            }
+          });
+          tileFill.assign(tileCounts.begin(), tileCounts.end());
+        } else {
+          for (uint32_t i = 0; i < analyzedCommands.size(); ++i) {
+            if (!count_command(i, tileCounts)) continue;
+            auto const& analyzed = analyzedCommands[i];
+            if (analyzed.type == CommandType::Rect && analyzed.index < rectActive.size()) {
+              rectActive[analyzed.index] = 1;
+            }
+            if (analyzed.type == CommandType::Text && analyzed.index < textActive.size()) {
+              textActive[analyzed.index] = 1;
+            }
+          }
+
+          tileOffsets.assign(tileCount + 1, 0);
+          for (uint32_t i = 0; i < tileCount; ++i) {
+            tileOffsets[i + 1] = tileOffsets[i] + tileCounts[i];
+          }
+          tileRefs.assign(tileOffsets.back(), 0);
+          tileFill.assign(tileCount, 0);
+          for (uint32_t i = 0; i < batch.commands.size(); ++i) {
+            if (cmdActive[i] == 0 || cmdLarge[i] != 0) continue;
+            auto const& info = cmdTiles[i];
+            for (uint32_t ty = info.ty0; ty <= info.ty1; ++ty) {
+              for (uint32_t tx = info.tx0; tx <= info.tx1; ++tx) {
+                uint32_t tileIdx = ty * grid.tilesX + tx;
+                if (!visible_in_tile(i, tileIdx)) continue;
+                uint32_t offset = tileOffsets[tileIdx] + tileFill[tileIdx]++;
+                if (useCircleRefs) {
+                  auto const& cmd = batch.commands[i];
+                  tileRefs[offset] = cmd.type == CommandType::Circle ? cmd.index : i;
+                } else {
+                  tileRefs[offset] = i;
+                }
+              }
             }
           }
         }
 
-        tileOffsets.assign(tileCount + 1, 0);
-        for (uint32_t i = 0; i < tileCount; ++i) {
-          tileOffsets[i + 1] = tileOffsets[i] + tileCounts[i];
+        for (uint32_t i = 0; i < cmdLarge.size(); ++i) {
+          if (cmdLarge[i] != 0) {
+            largeRefs.push_back(i);
+          }
         }
-        tileRefs.assign(tileOffsets.back(), 0);
-        tileFill.assign(tileCount, 0);
-        for (uint32_t i = 0; i < batch.commands.size(); ++i) {
-          if (cmdActive[i] == 0) continue;
-          auto const& info = cmdTiles[i];
-          for (uint32_t ty = info.ty0; ty <= info.ty1; ++ty) {
-            for (uint32_t tx = info.tx0; tx <= info.tx1; ++tx) {
-              uint32_t tileIdx = ty * grid.tilesX + tx;
-              uint32_t offset = tileOffsets[tileIdx] + tileFill[tileIdx]++;
-              if (useCircleRefs) {
-                auto const& cmd = batch.commands[i];
-                tileRefs[offset] = cmd.type == CommandType::Circle ? cmd.index : i;
-              } else {
-                tileRefs[offset] = i;
-              }
+        if (!zKeys.empty() && !useCircleRefs) {
+          parallel_slices(tileCount, 64u, [&](uint32_t begin, uint32_t end) {
+            std::vector<uint32_t> scratch;
+            for (uint32_t tile = begin; tile < end; ++tile) {
+              sort_tile_refs_by_z(tileRefs.data() + tileOffsets[tile], tileCounts[tile], zKeys, scratch);
             }
+          });
+          std::stable_sort(largeRefs.begin(), largeRefs.end(), [&](uint32_t a, uint32_t b) {
+            return zKeys[a] < zKeys[b];
+          });
+        }
+        if (!largeRefs.empty()) {
+          if (hasOccluders) {
+            prepared.tileOccluderKeys = std::move(occluders);
           }
+          prepared.cmdZKeys = std::move(zKeys);
         }
       }
 
@@ -1690,88 +2256,165 @@ auto optimize_batch(RenderTarget target,
     };
     runBinningStage();
 
+    if (batch.adaptiveTiles && renderTiles.size() > 2) {
+      std::vector<uint32_t> tileLoad(tileCount, 0);
+      if (useTileStream) {
+        for (uint32_t i = 0; i < tileCount; ++i) {
+          tileLoad[i] = tileStream->offsets[i + 1] - tileStream->offsets[i];
+        }
+      } else if (tileOffsets.size() > tileCount) {
+        for (uint32_t i = 0; i < tileCount; ++i) {
+          tileLoad[i] = tileOffsets[i + 1] - tileOffsets[i];
+        }
+      }
+      for (uint32_t cmdIndex : largeRefs) {
+        auto const& info = cmdTiles[cmdIndex];
+        for (uint32_t ty = info.ty0; ty <= info.ty1; ++ty) {
+          for (uint32_t tx = info.tx0; tx <= info.tx1; ++tx) {
+            ++tileLoad[ty * grid.tilesX + tx];
+          }
+        }
+      }
+      build_tile_work(renderTiles, tileLoad, grid.tileSize, grid.tilesX, target.width, target.height,
+                      binning_pool().thread_count(), prepared.tileWork);
+    }
+
     auto runCacheBuildStage = [&]() {
+      auto fill_pm_lut = [](std::vector<uint8_t>& storeR,
+                            std::vector<uint8_t>& storeG,
+                            std::vector<uint8_t>& storeB,
+                            uint32_t offset,
+                            uint8_t cR,
+                            uint8_t cG,
+                            uint8_t cB) {
+        for (uint32_t cov = 0; cov < 256; ++cov) {
+          storeR[offset + cov] = static_cast<uint8_t>((static_cast<uint16_t>(cR) * cov + 127u) / 255u);
+          storeG[offset + cov] = static_cast<uint8_t>((static_cast<uint16_t>(cG) * cov + 127u) / 255u);
+          storeB[offset + cov] = static_cast<uint8_t>((static_cast<uint16_t>(cB) * cov + 127u) / 255u);
+        }
+      };
+
+      // Per-primitive fields are independent, so both caches run in three steps: fields over pool
+      // slices, a serial prefix over which entries need a 256-entry PM LUT, then the LUT fill.
       auto rectCacheStart = profile ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
       if (!rectActive.empty()) {
-        for (uint32_t i = 0; i < rectActive.size(); ++i) {
-          if (rectActive[i] == 0) continue;
-          uint32_t color = fetch_color(batch.rects.colorIndex, i, 0u);
-          uint8_t cR = static_cast<uint8_t>(color & 0xFFu);
-          uint8_t cG = static_cast<uint8_t>((color >> 8) & 0xFFu);
-          uint8_t cB = static_cast<uint8_t>((color >> 16) & 0xFFu);
-          uint8_t cA = static_cast<uint8_t>((color >> 24) & 0xFFu);
-          rectColorR[i] = cR;
-          rectColorG[i] = cG;
-          rectColorB[i] = cB;
-          rectColorA[i] = cA;
-          uint8_t opacity = batch.rects.opacity[i];
-          uint8_t baseAlpha = apply_opacity(cA, opacity);
-          rectBaseAlpha[i] = baseAlpha;
-          uint8_t flags = i < batch.rects.flags.size() ? batch.rects.flags[i] : 0u;
-          if ((flags & RectFlagClip) != 0u &&
-              i < batch.rects.clipX0.size() &&
-              i < batch.rects.clipY0.size() &&
-              i < batch.rects.clipX1.size() &&
-              i < batch.rects.clipY1.size()) {
-            rectClipEnabled[i] = 1;
-            rectClipX0[i] = batch.rects.clipX0[i];
-            rectClipY0[i] = batch.rects.clipY0[i];
-            rectClipX1[i] = batch.rects.clipX1[i];
-            rectClipY1[i] = batch.rects.clipY1[i];
-          }
-          bool hasGradient = (flags & RectFlagGradient) != 0u;
-          if (hasGradient) {
-            if (i >= batch.rects.gradientColor1Index.size() ||
-                i >= batch.rects.gradientDirX.size() ||
-                i >= batch.rects.gradientDirY.size()) {
-              hasGradient = false;
+        uint32_t rectCount = static_cast<uint32_t>(rectActive.size());
+        parallel_slices(rectCount, kParallelCacheThreshold, [&](uint32_t begin, uint32_t end) {
+          for (uint32_t i = begin; i < end; ++i) {
+            if (rectActive[i] == 0) continue;
+            uint32_t color = fetch_color(batch.rects.colorIndex, i, 0u);
+            uint8_t cR = static_cast<uint8_t>(color & 0xFFu);
+            uint8_t cG = static_cast<uint8_t>((color >> 8) & 0xFFu);
+            uint8_t cB = static_cast<uint8_t>((color >> 16) & 0xFFu);
+            uint8_t cA = static_cast<uint8_t>((color >> 24) & 0xFFu);
+            rectColorR[i] = cR;
+            rectColorG[i] = cG;
+            rectColorB[i] = cB;
+            rectColorA[i] = cA;
+            uint8_t opacity = batch.rects.opacity[i];
+            uint8_t baseAlpha = apply_opacity(cA, opacity);
+            rectBaseAlpha[i] = baseAlpha;
+            uint8_t flags = i < batch.rects.flags.size() ? batch.rects.flags[i] : 0u;
+            if ((flags & RectFlagClip) != 0u &&
+                i < batch.rects.clipX0.size() &&
+                i < batch.rects.clipY0.size() &&
+                i < batch.rects.clipX1.size() &&
+                i < batch.rects.clipY1.size()) {
+              rectClipEnabled[i] = 1;
+              rectClipX0[i] = batch.rects.clipX0[i];
+              rectClipY0[i] = batch.rects.clipY0[i];
+              rectClipX1[i] = batch.rects.clipX1[i];
+              rectClipY1[i] = batch.rects.clipY1[i];
             }
-          }
-          if (!hasGradient && baseAlpha == 255u) {
-            uint32_t offset = static_cast<uint32_t>(rectEdgePmRStore.size());
-            rectEdgeOffset[i] = offset;
-            rectEdgePmRStore.resize(static_cast<size_t>(offset) + 256);
-            rectEdgePmGStore.resize(static_cast<size_t>(offset) + 256);
-            rectEdgePmBStore.resize(static_cast<size_t>(offset) + 256);
-            for (uint32_t cov = 0; cov < 256; ++cov) {
-              rectEdgePmRStore[offset + cov] =
-                static_cast<uint8_t>((static_cast<uint16_t>(cR) * cov + 127u) / 255u);
-              rectEdgePmGStore[offset + cov] =
-                static_cast<uint8_t>((static_cast<uint16_t>(cG) * cov + 127u) / 255u);
-              rectEdgePmBStore[offset + cov] =
-                static_cast<uint8_t>((static_cast<uint16_t>(cB) * cov + 127u) / 255u);
+            bool hasGradient = (flags & RectFlagGradient) != 0u;
+            if (hasGradient) {
+              if (i >= batch.rects.gradientColor1Index.size() ||
+                  i >= batch.rects.gradientDirX.size() ||
+                  i >= batch.rects.gradientDirY.size()) {
+                hasGradient = false;
+              }
             }
-          }
-          if (hasGradient) {
-            rectHasGradient[i] = 1;
-            uint32_t g1 = fetch_color(batch.rects.gradientColor1Index, i, 0u);
-            rectGradColorR[i] = static_cast<uint8_t>(g1 & 0xFFu);
-            rectGradColorG[i] = static_cast<uint8_t>((g1 >> 8) & 0xFFu);
-            rectGradColorB[i] = static_cast<uint8_t>((g1 >> 16) & 0xFFu);
-            rectGradColorA[i] = static_cast<uint8_t>((g1 >> 24) & 0xFFu);
-            Vec2f dir{static_cast<float>(batch.rects.gradientDirX[i]) / 256.0f,
-                      static_cast<float>(batch.rects.gradientDirY[i]) / 256.0f};
-            dir = normalize_or_default(dir, Vec2f{0.0f, 1.0f});
-            rectGradDirX[i] = dir.x;
-            rectGradDirY[i] = dir.y;
-            int32_t x0 = batch.rects.x0[i];
-            int32_t y0 = batch.rects.y0[i];
-            int32_t x1 = batch.rects.x1[i];
-            int32_t y1 = batch.rects.y1[i];
-            Vec2f p0{static_cast<float>(x0), static_cast<float>(y0)};
-            Vec2f p1{static_cast<float>(x1), static_cast<float>(y0)};
-            Vec2f p2{static_cast<float>(x0), static_cast<float>(y1)};
-            Vec2f p3{static_cast<float>(x1), static_cast<float>(y1)};
-            float gmin = std::min({dot(p0, dir), dot(p1, dir), dot(p2, dir), dot(p3, dir)});
-            float gmax = std::max({dot(p0, dir), dot(p1, dir), dot(p2, dir), dot(p3, dir)});
-            if (std::abs(gmax - gmin) < 1e-5f) {
-              rectGradMin[i] = 0.0f;
-              rectGradInvRange[i] = 1.0f;
-            } else {
-              rectGradMin[i] = gmin;
-              rectGradInvRange[i] = 1.0f / (gmax - gmin);
+            if (!hasGradient && baseAlpha == 255u) {
+              rectEdgeOffset[i] = NeedsPmLut;
+            }
+            if (hasGradient) {
+              rectHasGradient[i] = 1;
+              uint32_t g1 = fetch_color(batch.rects.gradientColor1Index, i, 0u);
+              rectGradColorR[i] = static_cast<uint8_t>(g1 & 0xFFu);
+              rectGradColorG[i] = static_cast<uint8_t>((g1 >> 8) & 0xFFu);
+              rectGradColorB[i] = static_cast<uint8_t>((g1 >> 16) & 0xFFu);
+              rectGradColorA[i] = static_cast<uint8_t>((g1 >> 24) & 0xFFu);
+              Vec2f dir{static_cast<float>(batch.rects.gradientDirX[i]) / 256.0f,
+                        static_cast<float>(batch.rects.gradientDirY[i]) / 256.0f};
+              dir = normalize_or_default(dir, Vec2f{0.0f, 1.0f});
+              rectGradDirX[i] = dir.x;
+              rectGradDirY[i] = dir.y;
+              int32_t x0 = batch.rects.x0[i];
+              int32_t y0 = batch.rects.y0[i];
+              int32_t x1 = batch.rects.x1[i];
+              int32_t y1 = batch.rects.y1[i];
+              Vec2f p0{static_cast<float>(x0), static_cast<float>(y0)};
+              Vec2f p1{static_cast<float>(x1), static_cast<float>(y0)};
+              Vec2f p2{static_cast<float>(x0), static_cast<float>(y1)};
+              Vec2f p3{static_cast<float>(x1), static_cast<float>(y1)};
+              float gmin = std::min({dot(p0, dir), dot(p1, dir), dot(p2, dir), dot(p3, dir)});
+              float gmax = std::max({dot(p0, dir), dot(p1, dir), dot(p2, dir), dot(p3, dir)});
+              if (std::abs(gmax - gmin) < 1e-5f) {
+                rectGradMin[i] = 0.0f;
+                rectGradInvRange[i] = 1.0f;
+              } else {
+                rectGradMin[i] = gmin;
+                rectGradInvRange[i] = 1.0f / (gmax - gmin);
+              }
             }
           }
+        });
+
+        uint32_t lutOffset = 0;
+        for (uint32_t i = 0; i < rectCount; ++i) {
+          if (rectEdgeOffset[i] != NeedsPmLut) continue;
+          rectEdgeOffset[i] = lutOffset;
+          lutOffset += 256u;
+        }
+        rectEdgePmRStore.resize(lutOffset);
+        rectEdgePmGStore.resize(lutOffset);
+        rectEdgePmBStore.resize(lutOffset);
+        if (lutOffset > 0) {
+          parallel_slices(rectCount, kParallelCacheThreshold, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i) {
+              if (rectEdgeOffset[i] == InvalidOffset) continue;
+              fill_pm_lut(rectEdgePmRStore, rectEdgePmGStore, rectEdgePmBStore,
+                          rectEdgeOffset[i], rectColorR[i], rectColorG[i], rectColorB[i]);
+            }
+          });
+        }
+        if (!rectRecords.empty()) {
+          size_t geometryCount = std::min({batch.rects.x0.size(), batch.rects.y0.size(),
+                                           batch.rects.x1.size(), batch.rects.y1.size()});
+          parallel_slices(rectCount, kParallelCacheThreshold, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i) {
+              if (rectActive[i] == 0 || i >= geometryCount) continue;
+              OptimizedBatch::RectRecord& record = rectRecords[i];
+              record.x0 = batch.rects.x0[i];
+              record.y0 = batch.rects.y0[i];
+              record.x1 = batch.rects.x1[i];
+              record.y1 = batch.rects.y1[i];
+              record.edgeOffset = rectEdgeOffset[i];
+              record.radiusQ8_8 = i < batch.rects.radiusQ8_8.size() ? batch.rects.radiusQ8_8[i] : 0;
+              record.rotationQ8_8 = i < batch.rects.rotationQ8_8.size() ? batch.rects.rotationQ8_8[i] : 0;
+              record.colorR = rectColorR[i];
+              record.colorG = rectColorG[i];
+              record.colorB = rectColorB[i];
+              record.colorA = rectColorA[i];
+              record.baseAlpha = rectBaseAlpha[i];
+              record.opacity = batch.rects.opacity[i];
+              record.flags = i < batch.rects.flags.size() ? batch.rects.flags[i] : 0u;
+              uint8_t cacheFlags = 0;
+              if (rectHasGradient[i] != 0u) cacheFlags |= OptimizedBatch::RectRecordGradient;
+              if (rectClipEnabled[i] != 0u) cacheFlags |= OptimizedBatch::RectRecordClip;
+              record.cacheFlags = cacheFlags;
+            }
+          });
         }
       }
       if (profile) {
@@ -1780,45 +2423,62 @@ auto optimize_batch(RenderTarget target,
 
       auto textCacheStart = profile ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
       if (!textActive.empty()) {
-        for (uint32_t i = 0; i < textActive.size(); ++i) {
-          if (textActive[i] == 0) continue;
-          uint32_t color = fetch_color(batch.text.colorIndex, i, 0u);
-          uint8_t cR = static_cast<uint8_t>(color & 0xFFu);
-          uint8_t cG = static_cast<uint8_t>((color >> 8) & 0xFFu);
-          uint8_t cB = static_cast<uint8_t>((color >> 16) & 0xFFu);
-          uint8_t cA = static_cast<uint8_t>((color >> 24) & 0xFFu);
-          textColorR[i] = cR;
-          textColorG[i] = cG;
-          textColorB[i] = cB;
-          textColorA[i] = cA;
-          uint8_t opacity = batch.text.opacity[i];
-          uint8_t baseAlpha = apply_opacity(cA, opacity);
-          textBaseAlpha[i] = baseAlpha;
-          uint8_t flags = i < batch.text.flags.size() ? batch.text.flags[i] : 0u;
-          if ((flags & TextFlagClip) != 0u &&
-              i < batch.text.clipX0.size() &&
-              i < batch.text.clipY0.size() &&
-              i < batch.text.clipX1.size() &&
-              i < batch.text.clipY1.size()) {
-            textClipEnabled[i] = 1;
-            textClipX0[i] = batch.text.clipX0[i];
-            textClipY0[i] = batch.text.clipY0[i];
-            textClipX1[i] = batch.text.clipX1[i];
-            textClipY1[i] = batch.text.clipY1[i];
+        uint32_t textCount = static_cast<uint32_t>(textActive.size());
+        parallel_slices(textCount, kParallelCacheThreshold, [&](uint32_t begin, uint32_t end) {
+          for (uint32_t i = begin; i < end; ++i) {
+            if (textActive[i] == 0) continue;
+            uint32_t color = fetch_color(batch.text.colorIndex, i, 0u);
+            uint8_t cA = static_cast<uint8_t>((color >> 24) & 0xFFu);
+            textColorR[i] = static_cast<uint8_t>(color & 0xFFu);
+            textColorG[i] = static_cast<uint8_t>((color >> 8) & 0xFFu);
+            textColorB[i] = static_cast<uint8_t>((color >> 16) & 0xFFu);
+            textColorA[i] = cA;
+            uint8_t opacity = batch.text.opacity[i];
+            textBaseAlpha[i] = apply_opacity(cA, opacity);
+            uint8_t flags = i < batch.text.flags.size() ? batch.text.flags[i] : 0u;
+            if ((flags & TextFlagClip) != 0u &&
+                i < batch.text.clipX0.size() &&
+                i < batch.text.clipY0.size() &&
+                i < batch.text.clipX1.size() &&
+                i < batch.text.clipY1.size()) {
+              textClipEnabled[i] = 1;
+              textClipX0[i] = batch.text.clipX0[i];
+              textClipY0[i] = batch.text.clipY0[i];
+              textClipX1[i] = batch.text.clipX1[i];
+              textClipY1[i] = batch.text.clipY1[i];
+            }
           }
-          uint32_t offset = static_cast<uint32_t>(textPmRStore.size());
-          textPmOffset[i] = offset;
-          textPmRStore.resize(static_cast<size_t>(offset) + 256);
-          textPmGStore.resize(static_cast<size_t>(offset) + 256);
-          textPmBStore.resize(static_cast<size_t>(offset) + 256);
-          for (uint32_t cov = 0; cov < 256; ++cov) {
-            textPmRStore[offset + cov] =
-              static_cast<uint8_t>((static_cast<uint16_t>(cR) * cov + 127u) / 255u);
-            textPmGStore[offset + cov] =
-              static_cast<uint8_t>((static_cast<uint16_t>(cG) * cov + 127u) / 255u);
-            textPmBStore[offset + cov] =
-              static_cast<uint8_t>((static_cast<uint16_t>(cB) * cov + 127u) / 255u);
+        });
+
+        // Glyph spans are memoized per run, which entries share, so they stay on this thread.
+        uint32_t lutOffset = 0;
+        for (uint32_t i = 0; i < textCount; ++i) {
+          if (textActive[i] == 0) continue;
+          if (i < batch.text.runIndex.size()) {
+            uint32_t runIndex = batch.text.runIndex[i];
+            if (runIndex < batch.runs.glyphStart.size() && runIndex >= textRunSpanOffset.size()) {
+              textRunSpanOffset.resize(batch.runs.glyphStart.size(), RunSpanUnbuilt);
+            }
+            if (runIndex < textRunSpanOffset.size() && textRunSpanOffset[runIndex] == RunSpanUnbuilt) {
+              uint32_t spanOffset = static_cast<uint32_t>(textGlyphSpanX0.size());
+              bool built = append_glyph_spans(batch, runIndex, textGlyphSpanX0, textGlyphSpanMaxX1);
+              textRunSpanOffset[runIndex] = built ? spanOffset : InvalidOffset;
+            }
           }
+          textPmOffset[i] = lutOffset;
+          lutOffset += 256u;
+        }
+        textPmRStore.resize(lutOffset);
+        textPmGStore.resize(lutOffset);
+        textPmBStore.resize(lutOffset);
+        if (lutOffset > 0) {
+          parallel_slices(textCount, kParallelCacheThreshold, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i) {
+              if (textActive[i] == 0) continue;
+              fill_pm_lut(textPmRStore, textPmGStore, textPmBStore,
+                          textPmOffset[i], textColorR[i], textColorG[i], textColorB[i]);
+            }
+          });
         }
       }
       if (profile) {
@@ -1853,6 +2513,7 @@ void OptimizeRenderBatch(RenderTarget target, RenderBatch const& batch, Optimize
                   !batch.strictValidation &&
                   optimized.valid &&
                   optimized.sourceRevision == batch.revision &&
+                  optimized.sourceAutoTileStream == batch.autoTileStream &&
                   optimized.targetWidth == target.width &&
                   optimized.targetHeight == target.height;
   if (canReuse) {
@@ -1881,6 +2542,7 @@ void OptimizeRenderBatch(RenderTarget target, RenderBatch const& batch, Optimize
   optimize_batch(target, batch, optimized, tileSizeOverride, commandCounts);
   if (optimized.valid) {
     optimized.sourceRevision = batch.revision;
+    optimized.sourceAutoTileStream = batch.autoTileStream;
     if (batch.useCommandRevision) {
       optimized.commandCountsRevision = batch.commandRevision;
     }
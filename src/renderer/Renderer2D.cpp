@@ -193,6 +193,8 @@ struct TilePool {
   std::condition_variable cvDone;
   bool shutdown = false;
   bool workReady = false;
+  uint64_t generation = 0;
+  uint32_t activeWorkers = 0;
   uint32_t workCount = 0;
   uint32_t chunkSizeOverride = 0;
   std::atomic<uint32_t> nextWork{0};
@@ -250,6 +252,7 @@ struct TilePool {
       nextWork.store(0);
       workDone.store(0);
       workReady = true;
+      ++generation;
       profile = profileInput;
     }
     cv.notify_all();
@@ -257,20 +260,32 @@ struct TilePool {
     // Main thread helps.
     do_work(static_cast<uint32_t>(workers.size()));
 
+    // Workers that joined this run must leave do_work before the next run resets nextWork;
+    // otherwise a straggler would claim new indices with the old job and count.
     std::unique_lock<std::mutex> lock(mutex);
-    cvDone.wait(lock, [&]() { return workDone.load() >= workCount; });
+    cvDone.wait(lock, [&]() { return workDone.load() >= workCount && activeWorkers == 0; });
     workReady = false;
     profile = nullptr;
   }
 
   void worker_loop(uint32_t workerIndex) {
+    uint64_t seenGeneration = 0;
     for (;;) {
       {
         std::unique_lock<std::mutex> lock(mutex);
-        cv.wait(lock, [&]() { return shutdown || workReady; });
+        cv.wait(lock, [&]() { return shutdown || (workReady && generation != seenGeneration); });
         if (shutdown) return;
+        seenGeneration = generation;
+        ++activeWorkers;
       }
       do_work(workerIndex);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        --activeWorkers;
+        if (activeWorkers == 0) {
+          cvDone.notify_one();
+        }
+      }
     }
   }
 
@@ -327,6 +342,7 @@ struct ScheduledTileCommand {
   bool shouldRender = false;
   SkippedCommandReason skipReason = SkippedCommandReason::UnsupportedCommandType;
   bool hasLocalBounds = false;
+  bool coversTile = false;
   int32_t localX0 = 0;
   int32_t localY0 = 0;
   int32_t localX1 = 0;
@@ -342,9 +358,17 @@ public:
                        std::vector<uint32_t> const& tileRefs,
                        std::vector<RenderCommand> const& commands,
                        std::vector<AnalyzedCommand> const& analyzedCommands,
+                       OptimizedBatch const& prepared,
+                       bool frontToBack,
                        uint32_t tileIndex,
+                       uint32_t tileX,
+                       uint32_t tileY,
                        uint32_t tileOriginX,
-                       uint32_t tileOriginY)
+                       uint32_t tileOriginY,
+                       uint32_t regionX0,
+                       uint32_t regionY0,
+                       uint32_t regionX1,
+                       uint32_t regionY1)
       : useTileStream_(useTileStream),
         tileRefsAreCircleIndices_(tileRefsAreCircleIndices),
         tileStream_(tileStream),
@@ -352,8 +376,17 @@ public:
         tileRefs_(&tileRefs),
         commands_(&commands),
         analyzedCommands_(&analyzedCommands),
+        prepared_(&prepared),
+        frontToBack_(frontToBack),
+        tileIndex_(tileIndex),
+        tileX_(tileX),
+        tileY_(tileY),
         tileOriginX_(tileOriginX),
-        tileOriginY_(tileOriginY) {
+        tileOriginY_(tileOriginY),
+        regionX0_(regionX0),
+        regionY0_(regionY0),
+        regionX1_(regionX1),
+        regionY1_(regionY1) {
     if (useTileStream_) {
       cursor_ = tileStream_->offsets[tileIndex];
       end_ = tileStream_->offsets[tileIndex + 1];
@@ -364,6 +397,7 @@ public:
   }
 
   auto next(ScheduledTileCommand& out) -> bool {
+    if (next_large(out)) return true;
     if (useTileStream_) {
       if (cursor_ >= end_) return false;
       out = ScheduledTileCommand{};
@@ -432,6 +466,62 @@ public:
   }
 
 private:
+  // Same ordering key the optimizer sorts bins by: z sort key first, then command order.
+  auto draw_key(uint32_t cmdIndex) const -> uint64_t {
+    auto const& zKeys = prepared_->cmdZKeys;
+    uint64_t z = cmdIndex < zKeys.size() ? zKeys[cmdIndex] : 0u;
+    return (z << 32) | cmdIndex;
+  }
+
+  // Emits the next large command touching this tile when it sorts before the tile's own next ref,
+  // clipped to the region being rendered (the whole tile, or one sub-tile of it).
+  auto next_large(ScheduledTileCommand& out) -> bool {
+    auto const& largeRefs = prepared_->largeRefs;
+    if (largeRefs.empty() || tileRefsAreCircleIndices_) return false;
+    auto const& cmdTiles = prepared_->cmdTiles;
+    auto const& occluderKeys = prepared_->tileOccluderKeys;
+    while (largeCursor_ < largeRefs.size()) {
+      uint32_t cmdIndex = largeRefs[largeCursor_];
+      auto const& info = cmdTiles[cmdIndex];
+      bool touches = tileX_ >= info.tx0 && tileX_ <= info.tx1 && tileY_ >= info.ty0 && tileY_ <= info.ty1;
+      bool hidden = false;
+      if (touches && tileIndex_ < occluderKeys.size()) {
+        uint64_t key = draw_key(cmdIndex);
+        hidden = frontToBack_ ? key > occluderKeys[tileIndex_] : key < occluderKeys[tileIndex_];
+      }
+      if (touches && !hidden) break;
+      ++largeCursor_;
+    }
+    if (largeCursor_ >= largeRefs.size()) return false;
+    uint32_t cmdIndex = largeRefs[largeCursor_];
+    if (cursor_ < end_) {
+      uint32_t ownIndex = useTileStream_ ? tileStream_->commands[cursor_].order : (*tileRefs_)[cursor_];
+      if (draw_key(ownIndex) < draw_key(cmdIndex)) return false;
+    }
+    ++largeCursor_;
+    auto const& cmd = (*commands_)[cmdIndex];
+    auto const& info = cmdTiles[cmdIndex];
+    out = ScheduledTileCommand{};
+    out.type = cmd.type;
+    out.index = cmd.index;
+    out.hasKnownType = true;
+    out.shouldRender = true;
+    out.hasLocalBounds = true;
+    out.localX0 = std::max<int32_t>(info.x0, static_cast<int32_t>(regionX0_));
+    out.localY0 = std::max<int32_t>(info.y0, static_cast<int32_t>(regionY0_));
+    out.localX1 = std::min<int32_t>(info.x1, static_cast<int32_t>(regionX1_));
+    out.localY1 = std::min<int32_t>(info.y1, static_cast<int32_t>(regionY1_));
+    out.coversTile = out.localX0 == static_cast<int32_t>(regionX0_) &&
+                     out.localY0 == static_cast<int32_t>(regionY0_) &&
+                     out.localX1 == static_cast<int32_t>(regionX1_) &&
+                     out.localY1 == static_cast<int32_t>(regionY1_);
+    if (out.localX1 <= out.localX0 || out.localY1 <= out.localY0) {
+      out.shouldRender = false;
+      out.skipReason = SkippedCommandReason::InvalidLocalBounds;
+    }
+    return true;
+  }
+
   bool useTileStream_ = false;
   bool tileRefsAreCircleIndices_ = false;
   TileStream const* tileStream_ = nullptr;
@@ -439,10 +529,20 @@ private:
   std::vector<uint32_t> const* tileRefs_ = nullptr;
   std::vector<RenderCommand> const* commands_ = nullptr;
   std::vector<AnalyzedCommand> const* analyzedCommands_ = nullptr;
+  OptimizedBatch const* prepared_ = nullptr;
+  bool frontToBack_ = false;
+  uint32_t tileIndex_ = 0;
+  uint32_t tileX_ = 0;
+  uint32_t tileY_ = 0;
   uint32_t tileOriginX_ = 0;
   uint32_t tileOriginY_ = 0;
+  uint32_t regionX0_ = 0;
+  uint32_t regionY0_ = 0;
+  uint32_t regionX1_ = 0;
+  uint32_t regionY1_ = 0;
   uint32_t cursor_ = 0;
   uint32_t end_ = 0;
+  size_t largeCursor_ = 0;
 };
 
 auto isRectCommandDataValid(RenderBatch const& batch, uint32_t idx) -> bool {
@@ -513,6 +613,7 @@ void renderSetPixelKernel(RenderBatch const& batch,
                           bool hasLocalBounds,
                           int32_t localX0,
                           int32_t localY0,
+                          int32_t localX1,
                           uint32_t tx0,
                           uint32_t ty0,
                           uint32_t tx1,
@@ -533,9 +634,11 @@ void renderSetPixelKernel(RenderBatch const& batch,
   }
   int32_t px = batch.pixels.x[idx];
   int32_t py = batch.pixels.y[idx];
-  int32_t drawX = hasLocalBounds ? localX0 : px;
+  // Local bounds wider than one pixel are a coalesced run of same-colour pixels along the row.
+  int32_t drawX0 = hasLocalBounds ? std::max(localX0, static_cast<int32_t>(tx0)) : px;
+  int32_t drawX1 = hasLocalBounds ? std::min(localX1, static_cast<int32_t>(tx1)) : px + 1;
   int32_t drawY = hasLocalBounds ? localY0 : py;
-  if (drawX < static_cast<int32_t>(tx0) || drawX >= static_cast<int32_t>(tx1) ||
+  if (drawX0 < static_cast<int32_t>(tx0) || drawX1 > static_cast<int32_t>(tx1) || drawX1 <= drawX0 ||
       drawY < static_cast<int32_t>(ty0) || drawY >= static_cast<int32_t>(ty1)) {
     return;
   }
@@ -545,14 +648,18 @@ void renderSetPixelKernel(RenderBatch const& batch,
   uint8_t cG = paletteG[paletteIndex];
   uint8_t cB = paletteB[paletteIndex];
   uint8_t cA = paletteA[paletteIndex];
-  uint8_t* dst = rowPtr(drawY) + static_cast<size_t>(4 * drawX);
+  uint8_t* dst = rowPtr(drawY) + static_cast<size_t>(4 * drawX0);
   if (cA == 255u) {
-    writePx(dst, cR, cG, cB);
-  } else {
-    if (frontToBack && dst[3] >= OpaqueAlphaCutoff) return;
-    uint8_t pmR = mul_div_255(cR, cA);
-    uint8_t pmG = mul_div_255(cG, cA);
-    uint8_t pmB = mul_div_255(cB, cA);
+    for (int32_t x = drawX0; x < drawX1; ++x, dst += 4) {
+      writePx(dst, cR, cG, cB);
+    }
+    return;
+  }
+  uint8_t pmR = mul_div_255(cR, cA);
+  uint8_t pmG = mul_div_255(cG, cA);
+  uint8_t pmB = mul_div_255(cB, cA);
+  for (int32_t x = drawX0; x < drawX1; ++x, dst += 4) {
+    if (frontToBack && dst[3] >= OpaqueAlphaCutoff) continue;
     dst[0] = pmR;
     dst[1] = pmG;
     dst[2] = pmB;
@@ -813,6 +920,10 @@ void RenderOptimizedImpl(RenderTarget target, RenderBatch const& batch, Optimize
   auto const& textClipY0 = prepared.textClipY0;
   auto const& textClipX1 = prepared.textClipX1;
   auto const& textClipY1 = prepared.textClipY1;
+  auto const& textRunSpanOffset = prepared.textRunSpanOffset;
+  auto const& textGlyphSpanX0 = prepared.textGlyphSpanX0;
+  auto const& textGlyphSpanMaxX1 = prepared.textGlyphSpanMaxX1;
+  auto const& rectRecords = prepared.rectRecords;
   auto const& rectBaseAlpha = prepared.rectBaseAlpha;
   auto const& rectActive = prepared.rectActive;
   auto const& rectEdgeOffset = prepared.rectEdgeOffset;
@@ -909,7 +1020,28 @@ void RenderOptimizedImpl(RenderTarget target, RenderBatch const& batch, Optimize
     analysisConfig.tilePow2 = tilePow2;
     analysisConfig.tileShift = tileShift;
     analysisConfig.paletteOpaque = paletteOpaque;
-    analyzeCommands(batch, analysisConfig, analyzedCommands);
+    constexpr uint32_t kAnalysisChunk = 2048u;
+    uint32_t commandCount = static_cast<uint32_t>(batch.commands.size());
+    if (commandCount <= kAnalysisChunk) {
+      analyzeCommands(batch, analysisConfig, analyzedCommands);
+    } else {
+      // Order-preserving: every chunk fills its own slice of analyzedCommands.
+      analyzedCommands.resize(commandCount);
+      uint32_t chunks = (commandCount + kAnalysisChunk - 1u) / kAnalysisChunk;
+      tile_pool().run(chunks, [&](uint32_t chunk) {
+        uint32_t begin = chunk * kAnalysisChunk;
+        analyzeCommandRange(batch, analysisConfig, begin, std::min(begin + kAnalysisChunk, commandCount), analyzedCommands);
+      }, nullptr, 1u);
+    }
+    for (uint32_t cmdIndex : prepared.coalescedCommands) {
+      if (cmdIndex >= analyzedCommands.size() || cmdIndex >= prepared.cmdTiles.size()) continue;
+      auto const& info = prepared.cmdTiles[cmdIndex];
+      auto& analyzed = analyzedCommands[cmdIndex];
+      analyzed.x0 = info.x0;
+      analyzed.y0 = info.y0;
+      analyzed.x1 = info.x1;
+      analyzed.y1 = info.y1;
+    }
   }
   bool doProfile = profile != nullptr;
 
@@ -930,13 +1062,27 @@ void RenderOptimizedImpl(RenderTarget target, RenderBatch const& batch, Optimize
   std::array<std::array<std::atomic<uint64_t>, SkippedCommandReasonCount>, RendererProfileCommandTypeBuckets>
     skippedCommandsByTypeAndReason{};
 
-  auto render_tile = [&](uint32_t tileIndex) {
+  // Renders the whole tile, or sub-tile `part` of a split x split grid over it; every kernel
+  // clips to [tx0, tx1) x [ty0, ty1), while tile-stream coordinates stay relative to the tile.
+  auto render_tile = [&](uint32_t tileIndex, uint32_t split = 1, uint32_t part = 0) {
     uint32_t tx = tileIndex % tilesX;
     uint32_t ty = tileIndex / tilesX;
-    uint32_t tx0 = tx * tileSize;
-    uint32_t ty0 = ty * tileSize;
+    uint32_t tileX0 = tx * tileSize;
+    uint32_t tileY0 = ty * tileSize;
+    uint32_t tx0 = tileX0;
+    uint32_t ty0 = tileY0;
     uint32_t tx1 = std::min(tx0 + tileSize, target.width);
     uint32_t ty1 = std::min(ty0 + tileSize, target.height);
+    if (split > 1) {
+      uint32_t subSize = (tileSize + split - 1u) / split;
+      uint32_t sx0 = tileX0 + (part % split) * subSize;
+      uint32_t sy0 = tileY0 + (part / split) * subSize;
+      if (sx0 >= tx1 || sy0 >= ty1) return;
+      tx1 = std::min(sx0 + subSize, tx1);
+      ty1 = std::min(sy0 + subSize, ty1);
+      tx0 = sx0;
+      ty0 = sy0;
+    }
 
     bool frontToBack = batch.assumeFrontToBack && useTileBuffer;
     uint32_t tileArea = (tx1 - tx0) * (ty1 - ty0);
@@ -1045,9 +1191,17 @@ void RenderOptimizedImpl(RenderTarget target, RenderBatch const& batch, Optimize
                                    tileRefs,
                                    batch.commands,
                                    analyzedCommands,
+                                   prepared,
+                                   frontToBack,
                                    tileIndex,
+                                   tx,
+                                   ty,
+                                   tileX0,
+                                   tileY0,
                                    tx0,
-                                   ty0);
+                                   ty0,
+                                   tx1,
+                                   ty1);
     auto renderLineKernel = [&](uint32_t idx,
                                 bool hasLocalBounds,
                                 int32_t localX0,
@@ -1895,7 +2049,8 @@ void RenderOptimizedImpl(RenderTarget target, RenderBatch const& batch, Optimize
                                 int32_t localX0,
                                 int32_t localY0,
                                 int32_t localX1,
-                                int32_t localY1) {
+                                int32_t localY1,
+                                bool coversTile) {
       do {
         if (idx >= batch.rects.x0.size() ||
             idx >= batch.rects.y0.size() ||
@@ -1905,10 +2060,44 @@ void RenderOptimizedImpl(RenderTarget target, RenderBatch const& batch, Optimize
           continue;
         }
 
-        int32_t x0 = batch.rects.x0[idx];
-        int32_t y0 = batch.rects.y0[idx];
-        int32_t x1 = batch.rects.x1[idx];
-        int32_t y1 = batch.rects.y1[idx];
+        OptimizedBatch::RectRecord rect{};
+        if (idx < rectRecords.size()) {
+          rect = rectRecords[idx];
+        } else {
+          rect.x0 = batch.rects.x0[idx];
+          rect.y0 = batch.rects.y0[idx];
+          rect.x1 = batch.rects.x1[idx];
+          rect.y1 = batch.rects.y1[idx];
+          rect.radiusQ8_8 = idx < batch.rects.radiusQ8_8.size() ? batch.rects.radiusQ8_8[idx] : 0;
+          rect.rotationQ8_8 = idx < batch.rects.rotationQ8_8.size() ? batch.rects.rotationQ8_8[idx] : 0;
+          rect.opacity = idx < batch.rects.opacity.size() ? batch.rects.opacity[idx] : 255u;
+          rect.flags = idx < batch.rects.flags.size() ? batch.rects.flags[idx] : 0u;
+          if (idx < rectColorR.size()) {
+            rect.colorR = rectColorR[idx];
+            rect.colorG = rectColorG[idx];
+            rect.colorB = rectColorB[idx];
+            rect.colorA = rectColorA[idx];
+          } else {
+            uint32_t color = fetch_color(batch.rects.colorIndex, idx, 0u);
+            rect.colorR = static_cast<uint8_t>(color & 0xFFu);
+            rect.colorG = static_cast<uint8_t>((color >> 8) & 0xFFu);
+            rect.colorB = static_cast<uint8_t>((color >> 16) & 0xFFu);
+            rect.colorA = static_cast<uint8_t>((color >> 24) & 0xFFu);
+          }
+          rect.baseAlpha = idx < rectBaseAlpha.size() ? rectBaseAlpha[idx] : rect.colorA;
+          rect.edgeOffset = idx < rectEdgeOffset.size() ? rectEdgeOffset[idx] : InvalidOffset;
+          if (idx < rectHasGradient.size() && rectHasGradient[idx] != 0) {
+            rect.cacheFlags |= OptimizedBatch::RectRecordGradient;
+          }
+          if (idx < rectClipEnabled.size() && rectClipEnabled[idx] != 0u) {
+            rect.cacheFlags |= OptimizedBatch::RectRecordClip;
+          }
+        }
+
+        int32_t x0 = rect.x0;
+        int32_t y0 = rect.y0;
+        int32_t x1 = rect.x1;
+        int32_t y1 = rect.y1;
 
         int32_t drawX0 = hasLocalBounds ? localX0 : x0;
         int32_t drawY0 = hasLocalBounds ? localY0 : y0;
@@ -1925,30 +2114,16 @@ void RenderOptimizedImpl(RenderTarget target, RenderBatch const& batch, Optimize
           tileRectPixels += static_cast<uint64_t>(rx1 - rx0) * static_cast<uint64_t>(ry1 - ry0);
         }
 
-        uint16_t radiusQ = idx < batch.rects.radiusQ8_8.size() ? batch.rects.radiusQ8_8[idx] : 0;
-        float radius = static_cast<float>(radiusQ) / 256.0f;
-        int16_t rotationQ = idx < batch.rects.rotationQ8_8.size() ? batch.rects.rotationQ8_8[idx] : 0;
-        bool axisAligned = (rotationQ == 0);
-        float rotation = axisAligned ? 0.0f : static_cast<float>(rotationQ) / 256.0f;
-        uint8_t opacity = idx < batch.rects.opacity.size() ? batch.rects.opacity[idx] : 255u;
-        uint8_t flags = idx < batch.rects.flags.size() ? batch.rects.flags[idx] : 0u;
+        float radius = static_cast<float>(rect.radiusQ8_8) / 256.0f;
+        bool axisAligned = (rect.rotationQ8_8 == 0);
+        float rotation = axisAligned ? 0.0f : static_cast<float>(rect.rotationQ8_8) / 256.0f;
+        uint8_t opacity = rect.opacity;
+        uint8_t flags = rect.flags;
 
-        uint32_t color = fetch_color(batch.rects.colorIndex, idx, 0u);
-        uint8_t cR = 0;
-        uint8_t cG = 0;
-        uint8_t cB = 0;
-        uint8_t cA = 0;
-        if (idx < rectColorR.size()) {
-          cR = rectColorR[idx];
-          cG = rectColorG[idx];
-          cB = rectColorB[idx];
-          cA = rectColorA[idx];
-        } else {
-          cR = static_cast<uint8_t>(color & 0xFFu);
-          cG = static_cast<uint8_t>((color >> 8) & 0xFFu);
-          cB = static_cast<uint8_t>((color >> 16) & 0xFFu);
-          cA = static_cast<uint8_t>((color >> 24) & 0xFFu);
-        }
+        uint8_t cR = rect.colorR;
+        uint8_t cG = rect.colorG;
+        uint8_t cB = rect.colorB;
+        uint8_t cA = rect.colorA;
 
         uint8_t gR = cR;
         uint8_t gG = cG;
@@ -1958,7 +2133,7 @@ void RenderOptimizedImpl(RenderTarget target, RenderBatch const& batch, Optimize
         float gradMin = 0.0f;
         float gradInvRange = 1.0f;
         bool hasGradient = false;
-        if (idx < rectHasGradient.size() && rectHasGradient[idx] != 0) {
+        if ((rect.cacheFlags & OptimizedBatch::RectRecordGradient) != 0u) {
           hasGradient = true;
           gradDir.x = rectGradDirX[idx];
           gradDir.y = rectGradDirY[idx];
@@ -2012,7 +2187,7 @@ void RenderOptimizedImpl(RenderTarget target, RenderBatch const& batch, Optimize
 
         bool clipEnabled = false;
         IntRect clip{};
-        if (idx < rectClipEnabled.size() && rectClipEnabled[idx] != 0u) {
+        if ((rect.cacheFlags & OptimizedBatch::RectRecordClip) != 0u) {
           clipEnabled = true;
           clip.x0 = rectClipX0[idx];
           clip.y0 = rectClipY0[idx];
@@ -2066,8 +2241,8 @@ void RenderOptimizedImpl(RenderTarget target, RenderBatch const& batch, Optimize
         region.y1 = std::min<int32_t>(clipRect.y1, static_cast<int32_t>(ty1));
         if (region.x1 <= region.x0 || region.y1 <= region.y0) continue;
 
-        bool useEdgeTable = (idx < rectEdgeOffset.size() && rectEdgeOffset[idx] != 0xFFFFFFFFu);
-        uint32_t edgeOffset = useEdgeTable ? rectEdgeOffset[idx] : 0u;
+        bool useEdgeTable = rect.edgeOffset != InvalidOffset;
+        uint32_t edgeOffset = useEdgeTable ? rect.edgeOffset : 0u;
 
         bool gradientVertical = false;
         float gradSign = 1.0f;
@@ -2081,10 +2256,13 @@ void RenderOptimizedImpl(RenderTarget target, RenderBatch const& batch, Optimize
         }
 
         bool smoothBlend = (flags & RectFlagSmoothBlend) != 0u;
-        uint8_t baseAlpha = idx < rectBaseAlpha.size() ? rectBaseAlpha[idx] : cA;
+        uint8_t baseAlpha = rect.baseAlpha;
         auto fill_opaque_region = [&](int32_t x0f, int32_t y0f, int32_t x1f, int32_t y1f) {
           if (x1f <= x0f || y1f <= y0f) return;
-          if (frontToBack) {
+          bool wholeTile = coversTile && opaqueCount == 0 &&
+                           x0f == static_cast<int32_t>(tx0) && y0f == static_cast<int32_t>(ty0) &&
+                           x1f == static_cast<int32_t>(tx1) && y1f == static_cast<int32_t>(ty1);
+          if (frontToBack && !wholeTile) {
             for (int32_t y = y0f; y < y1f; ++y) {
               uint8_t* row = row_ptr(y) + static_cast<size_t>(4u * x0f);
               for (int32_t x = x0f; x < x1f; ++x, row += 4) {
@@ -2092,7 +2270,12 @@ void RenderOptimizedImpl(RenderTarget target, RenderBatch const& batch, Optimize
               }
             }
           } else {
-            uint32_t packed = color;
+            // Nothing in a fully covered tile is opaque yet, so every pixel takes the plain fill.
+            if (frontToBack) {
+              opaqueCount = tileArea;
+            }
+            uint32_t packed = static_cast<uint32_t>(cR) | (static_cast<uint32_t>(cG) << 8) |
+                              (static_cast<uint32_t>(cB) << 16) | (static_cast<uint32_t>(cA) << 24);
             for (int32_t y = y0f; y < y1f; ++y) {
               uint8_t* row = row_ptr(y) + static_cast<size_t>(4u * x0f);
               if ((reinterpret_cast<uintptr_t>(row) % alignof(uint32_t)) == 0) {
@@ -2394,12 +2577,67 @@ void RenderOptimizedImpl(RenderTarget target, RenderBatch const& batch, Optimize
           }
         }
 
+        if ((flags & TextFlagSprite) != 0u && runIndex < batch.runs.spriteIndex.size() &&
+            batch.runs.spriteIndex[runIndex] < batch.runs.sprites.size()) {
+          auto const& sprite = batch.runs.sprites[batch.runs.spriteIndex[runIndex]];
+          int32_t sx0 = x0 + sprite.x;
+          int32_t sy0 = y0 + sprite.y;
+          int32_t cx0 = std::max<int32_t>(sx0, static_cast<int32_t>(tx0));
+          int32_t cy0 = std::max<int32_t>(sy0, static_cast<int32_t>(ty0));
+          int32_t cx1 = std::min<int32_t>(sx0 + sprite.width, static_cast<int32_t>(tx1));
+          int32_t cy1 = std::min<int32_t>(sy0 + sprite.height, static_cast<int32_t>(ty1));
+          if (clipEnabled) {
+            cx0 = std::max<int32_t>(cx0, clip.x0);
+            cy0 = std::max<int32_t>(cy0, clip.y0);
+            cx1 = std::min<int32_t>(cx1, clip.x1);
+            cy1 = std::min<int32_t>(cy1, clip.y1);
+          }
+          if (hasLocalBounds) {
+            cx0 = std::max<int32_t>(cx0, localX0);
+            cy0 = std::max<int32_t>(cy0, localY0);
+            cx1 = std::min<int32_t>(cx1, localX1);
+            cy1 = std::min<int32_t>(cy1, localY1);
+          }
+          if (cx1 <= cx0 || cy1 <= cy0) continue;
+          if (profile) {
+            tileTextPixels += static_cast<uint64_t>(cx1 - cx0) * static_cast<uint64_t>(cy1 - cy0);
+          }
+          for (int32_t y = cy0; y < cy1; ++y) {
+            const uint8_t* src = sprite.coverage.data() + static_cast<size_t>(y - sy0) * sprite.width +
+                                 static_cast<size_t>(cx0 - sx0);
+            uint8_t* row = row_ptr(y) + static_cast<size_t>(4 * cx0);
+            for (int32_t x = cx0; x < cx1; ++x, ++src, row += 4) {
+              uint8_t cov = *src;
+              if (cov == 0) continue;
+              if (opaqueText) {
+                if (cov == 255) {
+                  write_px(row, cR, cG, cB);
+                } else {
+                  blend_px(row, textPmR[cov], textPmG[cov], textPmB[cov], cov);
+                }
+              } else {
+                uint8_t finalA = apply_coverage(baseAlpha, cov);
+                if (finalA == 0) continue;
+                uint8_t pmR = static_cast<uint8_t>((static_cast<uint16_t>(cR) * finalA + 127u) / 255u);
+                uint8_t pmG = static_cast<uint8_t>((static_cast<uint16_t>(cG) * finalA + 127u) / 255u);
+                uint8_t pmB = static_cast<uint8_t>((static_cast<uint16_t>(cB) * finalA + 127u) / 255u);
+                blend_px(row, pmR, pmG, pmB, finalA);
+              }
+            }
+          }
+          continue;
+        }
+
         uint32_t glyphStart = batch.runs.glyphStart[runIndex];
         uint32_t glyphCount = batch.runs.glyphCount[runIndex];
         float baseline = static_cast<float>(batch.runs.baselineQ8_8[runIndex]) / 256.0f;
         float scale = static_cast<float>(batch.runs.scaleQ8_8[runIndex]) / 256.0f;
         if (scale <= 0.0f || glyphCount == 0) continue;
         float baseY = static_cast<float>(y0) + baseline * scale;
+        float glyphScale = 1.0f;
+        if (runIndex < batch.runs.glyphScaleQ8_8.size() && batch.runs.glyphScaleQ8_8[runIndex] != 0u) {
+          glyphScale = static_cast<float>(batch.runs.glyphScaleQ8_8[runIndex]) / 256.0f;
+        }
 
         uint32_t glyphEnd = glyphStart + glyphCount;
         if (glyphEnd > batch.glyphs.glyphXQ8_8.size() ||
@@ -2408,19 +2646,65 @@ void RenderOptimizedImpl(RenderTarget target, RenderBatch const& batch, Optimize
           continue;
         }
 
-        for (uint32_t gi = glyphStart; gi < glyphEnd; ++gi) {
+        // Runs with glyph spans only visit glyphs whose x span reaches this tile's columns.
+        uint32_t firstGlyph = glyphStart;
+        const int32_t* spanX0 = nullptr;
+        int32_t spanLimit = 0;
+        if (runIndex < textRunSpanOffset.size()) {
+          uint32_t spanOffset = textRunSpanOffset[runIndex];
+          if (spanOffset < textGlyphSpanX0.size() &&
+              textGlyphSpanX0.size() - spanOffset >= glyphCount &&
+              textGlyphSpanMaxX1.size() == textGlyphSpanX0.size()) {
+            int32_t colX0 = static_cast<int32_t>(tx0);
+            int32_t colX1 = static_cast<int32_t>(tx1);
+            if (clipEnabled) {
+              colX0 = std::max<int32_t>(colX0, clip.x0);
+              colX1 = std::min<int32_t>(colX1, clip.x1);
+            }
+            if (hasLocalBounds) {
+              colX0 = std::max<int32_t>(colX0, localX0);
+              colX1 = std::min<int32_t>(colX1, localX1);
+            }
+            if (colX1 <= colX0) continue;
+            const int32_t* maxX1 = textGlyphSpanMaxX1.data() + spanOffset;
+            firstGlyph = glyphStart + static_cast<uint32_t>(
+              std::upper_bound(maxX1, maxX1 + glyphCount, colX0 - x0) - maxX1);
+            spanX0 = textGlyphSpanX0.data() + spanOffset;
+            spanLimit = colX1 - x0;
+          }
+        }
+
+        for (uint32_t gi = firstGlyph; gi < glyphEnd; ++gi) {
+          if (spanX0 && spanX0[gi - glyphStart] >= spanLimit) break;
           uint32_t bitmapIndex = batch.glyphs.bitmapIndex[gi];
           if (bitmapIndex >= batch.glyphs.bitmaps.size()) continue;
           auto const& bmp = batch.glyphs.bitmaps[bitmapIndex];
           if (bmp.width <= 0 || bmp.height <= 0) continue;
           float gx = static_cast<float>(batch.glyphs.glyphXQ8_8[gi]) / 256.0f;
           float gy = static_cast<float>(batch.glyphs.glyphYQ8_8[gi]) / 256.0f;
-          int32_t gx0 = static_cast<int32_t>(std::lround(static_cast<float>(x0) + gx * scale +
-                                                        static_cast<float>(bmp.bearingX)));
-          int32_t gy0 = static_cast<int32_t>(std::lround(baseY + gy * scale -
-                                                        static_cast<float>(bmp.bearingY)));
-          int32_t gx1 = gx0 + bmp.width;
-          int32_t gy1 = gy0 + bmp.height;
+          bool sdfGlyph = bmp.format == GlyphBitmapFormat::Sdf8;
+          float sdfOriginX = 0.0f;
+          float sdfOriginY = 0.0f;
+          int32_t gx0 = 0;
+          int32_t gy0 = 0;
+          int32_t gx1 = 0;
+          int32_t gy1 = 0;
+          if (sdfGlyph) {
+            sdfOriginX = static_cast<float>(x0) + gx * scale + static_cast<float>(bmp.bearingX) * glyphScale;
+            sdfOriginY = baseY + gy * scale - static_cast<float>(bmp.bearingY) * glyphScale;
+            gx0 = static_cast<int32_t>(std::floor(sdfOriginX));
+            gy0 = static_cast<int32_t>(std::floor(sdfOriginY));
+            gx1 = static_cast<int32_t>(std::ceil(sdfOriginX + static_cast<float>(bmp.width) * glyphScale));
+            gy1 = static_cast<int32_t>(std::ceil(sdfOriginY + static_cast<float>(bmp.height) * glyphScale));
+          } else {
+            float subpixelShift = static_cast<float>(bmp.subpixelBin) / static_cast<float>(GlyphSubpixelBins);
+            gx0 = static_cast<int32_t>(std::lround(static_cast<float>(x0) + gx * scale +
+                                                   static_cast<float>(bmp.bearingX) - subpixelShift));
+            gy0 = static_cast<int32_t>(std::lround(baseY + gy * scale -
+                                                   static_cast<float>(bmp.bearingY)));
+            gx1 = gx0 + bmp.width;
+            gy1 = gy0 + bmp.height;
+          }
 
           int32_t cx0 = std::max<int32_t>(gx0, static_cast<int32_t>(tx0));
           int32_t cy0 = std::max<int32_t>(gy0, static_cast<int32_t>(ty0));
@@ -2445,6 +2729,56 @@ void RenderOptimizedImpl(RenderTarget target, RenderBatch const& batch, Optimize
             tileTextPixels += static_cast<uint64_t>(cx1 - cx0) * static_cast<uint64_t>(cy1 - cy0);
           }
 
+          if (sdfGlyph) {
+            const uint8_t* field = bmp.pixels.data();
+            int32_t fieldStride = bmp.stride;
+            if (!field || fieldStride <= 0 ||
+                bmp.pixels.size() < static_cast<size_t>(fieldStride) * static_cast<size_t>(bmp.height)) {
+              continue;
+            }
+            float invGlyphScale = 1.0f / glyphScale;
+            // Field units -> device pixels: one field pixel spans glyphScale device pixels.
+            float distScale = static_cast<float>(GlyphSdfSpread) / 127.0f * glyphScale;
+            float maxU = static_cast<float>(bmp.width - 1);
+            float maxV = static_cast<float>(bmp.height - 1);
+            for (int32_t y = cy0; y < cy1; ++y) {
+              float v = std::clamp((static_cast<float>(y) + 0.5f - sdfOriginY) * invGlyphScale - 0.5f, 0.0f, maxV);
+              int32_t v0 = static_cast<int32_t>(v);
+              int32_t v1 = std::min(v0 + 1, bmp.height - 1);
+              float fv = v - static_cast<float>(v0);
+              const uint8_t* row0 = field + static_cast<size_t>(v0) * fieldStride;
+              const uint8_t* row1 = field + static_cast<size_t>(v1) * fieldStride;
+              uint8_t* row = row_ptr(y) + static_cast<size_t>(4 * cx0);
+              for (int32_t x = cx0; x < cx1; ++x, row += 4) {
+                float u = std::clamp((static_cast<float>(x) + 0.5f - sdfOriginX) * invGlyphScale - 0.5f, 0.0f, maxU);
+                int32_t u0 = static_cast<int32_t>(u);
+                int32_t u1 = std::min(u0 + 1, bmp.width - 1);
+                float fu = u - static_cast<float>(u0);
+                float top = static_cast<float>(row0[u0]) + (static_cast<float>(row0[u1]) - row0[u0]) * fu;
+                float bottom = static_cast<float>(row1[u0]) + (static_cast<float>(row1[u1]) - row1[u0]) * fu;
+                float dist = (top + (bottom - top) * fv - 128.0f) * distScale;
+                if (dist <= -0.5f) continue;
+                uint8_t cov = dist >= 0.5f ? 255u : static_cast<uint8_t>((dist + 0.5f) * 255.0f + 0.5f);
+                if (cov == 0) continue;
+                if (opaqueText) {
+                  if (cov == 255) {
+                    write_px(row, cR, cG, cB);
+                  } else {
+                    blend_px(row, textPmR[cov], textPmG[cov], textPmB[cov], cov);
+                  }
+                } else {
+                  uint8_t finalA = apply_coverage(baseAlpha, cov);
+                  if (finalA == 0) continue;
+                  uint8_t pmR = static_cast<uint8_t>((static_cast<uint16_t>(cR) * finalA + 127u) / 255u);
+                  uint8_t pmG = static_cast<uint8_t>((static_cast<uint16_t>(cG) * finalA + 127u) / 255u);
+                  uint8_t pmB = static_cast<uint8_t>((static_cast<uint16_t>(cB) * finalA + 127u) / 255u);
+                  blend_px(row, pmR, pmG, pmB, finalA);
+                }
+              }
+            }
+            continue;
+          }
+
           bool colorGlyph = bmp.format == GlyphBitmapFormat::ColorBGRA;
           if (opaqueText && !colorGlyph) {
             bool glyphOpaque = false;
@@ -2512,6 +2846,63 @@ void RenderOptimizedImpl(RenderTarget target, RenderBatch const& batch, Optimize
             continue;
           }
 
+          if (bmp.maskSpanRows.size() == static_cast<size_t>(bmp.height) + 1u) {
+            int32_t colX0 = cx0 - gx0;
+            int32_t colX1 = cx1 - gx0;
+            uint8_t solidA = opaqueText ? 255u : apply_coverage(baseAlpha, 255u);
+            uint8_t solidR = static_cast<uint8_t>((static_cast<uint16_t>(cR) * solidA + 127u) / 255u);
+            uint8_t solidG = static_cast<uint8_t>((static_cast<uint16_t>(cG) * solidA + 127u) / 255u);
+            uint8_t solidB = static_cast<uint8_t>((static_cast<uint16_t>(cB) * solidA + 127u) / 255u);
+            size_t spanLimit = bmp.maskSpans.size();
+            for (int32_t y = cy0; y < cy1; ++y) {
+              size_t rowIndex = static_cast<size_t>(y - gy0);
+              size_t t = bmp.maskSpanRows[rowIndex];
+              size_t tEnd = std::min<size_t>(bmp.maskSpanRows[rowIndex + 1u], spanLimit);
+              uint8_t* rowBase = row_ptr(y);
+              int32_t c = 0;
+              while (t < tEnd && c < colX1) {
+                uint8_t token = bmp.maskSpans[t++];
+                uint8_t kind = static_cast<uint8_t>(token >> 6);
+                int32_t len = static_cast<int32_t>(token & 0x3Fu) + 1;
+                const uint8_t* covBytes = bmp.maskSpans.data() + t;
+                if (kind == GlyphSpanBlend) {
+                  if (tEnd - t < static_cast<size_t>(len)) break;
+                  t += static_cast<size_t>(len);
+                }
+                int32_t s0 = std::max(c, colX0);
+                int32_t s1 = std::min(c + len, colX1);
+                if (s0 < s1 && kind == GlyphSpanSolid) {
+                  uint8_t* row = rowBase + static_cast<size_t>(4 * (gx0 + s0));
+                  for (int32_t x = s0; x < s1; ++x, row += 4) {
+                    if (solidA == 255u) {
+                      write_px(row, cR, cG, cB);
+                    } else if (solidA != 0u) {
+                      blend_px(row, solidR, solidG, solidB, solidA);
+                    }
+                  }
+                } else if (s0 < s1 && kind == GlyphSpanBlend) {
+                  uint8_t* row = rowBase + static_cast<size_t>(4 * (gx0 + s0));
+                  const uint8_t* src = covBytes + (s0 - c);
+                  for (int32_t x = s0; x < s1; ++x, ++src, row += 4) {
+                    uint8_t cov = *src;
+                    if (opaqueText) {
+                      blend_px(row, textPmR[cov], textPmG[cov], textPmB[cov], cov);
+                    } else {
+                      uint8_t finalA = apply_coverage(baseAlpha, cov);
+                      if (finalA == 0) continue;
+                      uint8_t pmR = static_cast<uint8_t>((static_cast<uint16_t>(cR) * finalA + 127u) / 255u);
+                      uint8_t pmG = static_cast<uint8_t>((static_cast<uint16_t>(cG) * finalA + 127u) / 255u);
+                      uint8_t pmB = static_cast<uint8_t>((static_cast<uint16_t>(cB) * finalA + 127u) / 255u);
+                      blend_px(row, pmR, pmG, pmB, finalA);
+                    }
+                  }
+                }
+                c += len;
+              }
+            }
+            continue;
+          }
+
           const uint8_t* srcBase = nullptr;
           int32_t srcStride = bmp.stride;
           if (bmp.atlasIndex >= 0 && bmp.atlasIndex < static_cast<int32_t>(batch.glyphs.atlases.size())) {
@@ -2579,7 +2970,7 @@ void RenderOptimizedImpl(RenderTarget target, RenderBatch const& batch, Optimize
           record_skipped_known(type, SkippedCommandReason::InvalidCommandData);
           continue;
         }
-        renderRectKernel(idx, hasLocalBounds, localX0, localY0, localX1, localY1);
+        renderRectKernel(idx, hasLocalBounds, localX0, localY0, localX1, localY1, scheduled.coversTile);
       } else if (type == CommandType::Circle) {
         if (doProfile && !isCircleCommandDataValid(batch, idx)) {
           record_skipped_known(type, SkippedCommandReason::InvalidCommandData);
@@ -2602,6 +2993,7 @@ void RenderOptimizedImpl(RenderTarget target, RenderBatch const& batch, Optimize
                              hasLocalBounds,
                              localX0,
                              localY0,
+                             localX1,
                              tx0,
                              ty0,
                              tx1,
@@ -2724,7 +3116,9 @@ void RenderOptimizedImpl(RenderTarget target, RenderBatch const& batch, Optimize
     }
 
     if (profile) {
-      renderedTiles.fetch_add(1, std::memory_order_relaxed);
+      if (part == 0) {
+        renderedTiles.fetch_add(1, std::memory_order_relaxed);
+      }
       renderedCommands.fetch_add(tileCommands, std::memory_order_relaxed);
       renderedPixels.fetch_add(tilePixels, std::memory_order_relaxed);
       renderedRects.fetch_add(tileRects, std::memory_order_relaxed);
@@ -2778,13 +3172,30 @@ void RenderOptimizedImpl(RenderTarget target, RenderBatch const& batch, Optimize
       if (!useTileStream && prepared.tileRefsAreCircleIndices) {
         chunkOverride = 1u;
       }
-      pool.run(static_cast<uint32_t>(renderTiles.size()),
-               [&](uint32_t jobIndex) {
-        uint32_t tileIndex = renderTiles[jobIndex];
-        render_tile(tileIndex);
-               },
-               profilePtr,
-               chunkOverride);
+      auto const& tileWork = prepared.tileWork;
+      if (!tileWork.empty()) {
+        pool.run(static_cast<uint32_t>(tileWork.size()),
+                 [&](uint32_t jobIndex) {
+          auto const& unit = tileWork[jobIndex];
+          if (unit.split > 1) {
+            render_tile(renderTiles[unit.first], unit.split, unit.part);
+            return;
+          }
+          for (uint32_t i = 0; i < unit.tileCount; ++i) {
+            render_tile(renderTiles[unit.first + i]);
+          }
+                 },
+                 profilePtr,
+                 1u);
+      } else {
+        pool.run(static_cast<uint32_t>(renderTiles.size()),
+                 [&](uint32_t jobIndex) {
+          uint32_t tileIndex = renderTiles[jobIndex];
+          render_tile(tileIndex);
+                 },
+                 profilePtr,
+                 chunkOverride);
+      }
       if (profilePtr) {
         size_t workerCount = poolProfile.activeNs.size();
         profile->workerNs.resize(workerCount);
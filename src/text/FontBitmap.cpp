@@ -1,6 +1,8 @@
 #include "PrimeManifest/text/FontBitmap.hpp"
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace PrimeManifest {
 
@@ -70,4 +72,59 @@ bool ConvertFontBitmapToAlpha(FontBitmapView view,
   return false;
 }
 
+bool BuildGlyphDistanceField(const uint8_t* coverage,
+                             int32_t width,
+                             int32_t height,
+                             int32_t stride,
+                             int32_t spread,
+                             std::vector<uint8_t>& outPixels,
+                             int32_t& outWidth,
+                             int32_t& outHeight) {
+  outPixels.clear();
+  outWidth = 0;
+  outHeight = 0;
+  if (!coverage || width <= 0 || height <= 0 || stride < width || spread <= 0) return false;
+
+  outWidth = width + spread * 2;
+  outHeight = height + spread * 2;
+  outPixels.resize(static_cast<size_t>(outWidth) * outHeight);
+
+  auto sample = [&](int32_t x, int32_t y) -> uint8_t {
+    int32_t sx = x - spread;
+    int32_t sy = y - spread;
+    if (sx < 0 || sy < 0 || sx >= width || sy >= height) return 0u;
+    return coverage[static_cast<size_t>(sy) * stride + static_cast<size_t>(sx)];
+  };
+
+  float encodeScale = 127.0f / static_cast<float>(spread);
+  for (int32_t y = 0; y < outHeight; ++y) {
+    for (int32_t x = 0; x < outWidth; ++x) {
+      uint8_t cov = sample(x, y);
+      bool inside = cov >= 128u;
+      float dist = static_cast<float>(spread);
+      if (cov != 0u && cov != 255u) {
+        dist = std::abs(static_cast<float>(cov) / 255.0f - 0.5f);
+      } else {
+        int32_t bestSq = std::numeric_limits<int32_t>::max();
+        for (int32_t dy = -spread; dy <= spread; ++dy) {
+          for (int32_t dx = -spread; dx <= spread; ++dx) {
+            int32_t distSq = dx * dx + dy * dy;
+            if (distSq >= bestSq) continue;
+            if ((sample(x + dx, y + dy) >= 128u) != inside) {
+              bestSq = distSq;
+            }
+          }
+        }
+        if (bestSq != std::numeric_limits<int32_t>::max()) {
+          dist = std::min(dist, std::sqrt(static_cast<float>(bestSq)) - 0.5f);
+        }
+      }
+      float encoded = 128.0f + (inside ? dist : -dist) * encodeScale;
+      outPixels[static_cast<size_t>(y) * outWidth + static_cast<size_t>(x)] =
+        static_cast<uint8_t>(std::clamp(std::lround(encoded), 0l, 255l));
+    }
+  }
+  return true;
+}
+
 } // namespace PrimeManifest
@@ -4,6 +4,8 @@
 #include "PrimeManifest/util/BitmapFont.hpp"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cctype>
 #include <cmath>
 #include <cstdlib>
@@ -12,11 +14,23 @@
 #include <fstream>
 #include <limits>
 #include <mutex>
+#include <optional>
+#include <thread>
+#include <tuple>
 #include <unordered_map>
+#include <unordered_set>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include FT_OUTLINE_H
+#include FT_SIZES_H
 #include FT_TRUETYPE_TABLES_H
 #include <hb.h>
 #include <hb-ft.h>
@@ -31,8 +45,8 @@ struct Utf8Codepoint {
   size_t byteLength = 0;
 };
 
-auto decode_utf8(std::string_view text) -> std::vector<Utf8Codepoint> {
-  std::vector<Utf8Codepoint> out;
+void decode_utf8(std::string_view text, std::vector<Utf8Codepoint>& out) {
+  out.clear();
   size_t i = 0;
   while (i < text.size()) {
     unsigned char c = static_cast<unsigned char>(text[i]);
@@ -66,22 +80,111 @@ auto decode_utf8(std::string_view text) -> std::vector<Utf8Codepoint> {
     }
     out.push_back(cp);
   }
-  return out;
 }
 
+// Read-only view of a font file. Mapped with mmap where available so FreeType reads straight
+// from the page cache; falls back to an owned copy otherwise.
+struct MappedFile {
+  const uint8_t* data = nullptr;
+  size_t size = 0;
+  std::vector<uint8_t> owned;
+  void* mapping = nullptr;
+
+  MappedFile() = default;
+  MappedFile(MappedFile const&) = delete;
+  MappedFile& operator=(MappedFile const&) = delete;
+  ~MappedFile() {
+#if !defined(_WIN32)
+    if (mapping) munmap(mapping, size);
+#endif
+  }
+
+  static auto open(std::string const& path, bool allowMapping = true) -> std::shared_ptr<MappedFile> {
+    auto file = std::make_shared<MappedFile>();
+#if !defined(_WIN32)
+    int fd = allowMapping ? ::open(path.c_str(), O_RDONLY) : -1;
+    if (fd >= 0) {
+      struct stat st{};
+      if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+          file->mapping = mapped;
+          file->data = static_cast<const uint8_t*>(mapped);
+          file->size = static_cast<size_t>(st.st_size);
+        }
+      }
+      ::close(fd);
+      if (file->mapping) return file;
+    }
+#endif
+    std::ifstream input(path, std::ios::binary);
+    if (!input.is_open()) return nullptr;
+    input.seekg(0, std::ios::end);
+    std::streamoff size = input.tellg();
+    if (size <= 0) return nullptr;
+    input.seekg(0, std::ios::beg);
+    file->owned.resize(static_cast<size_t>(size));
+    input.read(reinterpret_cast<char*>(file->owned.data()), size);
+    if (!input) return nullptr;
+    file->data = file->owned.data();
+    file->size = file->owned.size();
+    return file;
+  }
+};
+
+struct FontBuffer {
+  std::string name;
+  std::shared_ptr<MappedFile> file;
+  const uint8_t* data = nullptr;
+  size_t size = 0;
+};
+
+// Faces are registered from a metadata scan; the FT_Face/hb_font pair is opened on first use.
 struct FontFace {
   uint32_t id = 0;
   std::string family;
   uint16_t weight = 400;
   FontSlant slant = FontSlant::Upright;
   FT_Face face = nullptr;
-  hb_font_t* hbFont = nullptr;
   bool fromBundle = false;
+  FontBuffer source;
+  FT_Long faceIndex = 0;
+  bool openFailed = false;
 };
 
-struct FontBuffer {
-  std::string name;
-  std::vector<uint8_t> data;
+// Two-level itemization table for one primary face: Unicode block (codepoint >> 8) -> page of
+// 256 slots into `faces`. Pages are filled from the primary and bundled cmaps when a block is
+// first seen; codepoints none of them cover are resolved against OS fonts on first use.
+struct FallbackTable {
+  static constexpr uint16_t Unresolved = std::numeric_limits<uint16_t>::max();
+  static constexpr uint32_t BlockCount = 0x110000u >> 8;
+  std::vector<FontFace*> faces;
+  std::vector<uint16_t> blockPages;
+  std::vector<std::array<uint16_t, 256>> pages;
+};
+
+// HarfBuzz output for printable ASCII on one sized face, captured per glyph and per adjacent
+// pair with the Latin script forced. Latin text without features is laid out from these tables
+// when every pair in it shaped as two independent glyphs, skipping hb_shape entirely.
+struct AsciiShapeTable {
+  static constexpr uint32_t First = 0x20u;
+  static constexpr uint32_t Count = 0x7Fu - First;
+  static constexpr int32_t Complex = std::numeric_limits<int32_t>::min();
+  std::array<uint32_t, Count> glyph{};
+  std::array<int32_t, Count> advance{};
+  std::array<bool, Count> simple{};
+  std::array<bool, Count> rowBuilt{};
+  std::vector<int32_t> kern;
+};
+
+// One pixel size of a face: its own FT_Size plus a HarfBuzz font created while that size was
+// active, so switching sizes is an FT_Activate_Size instead of a resize and cache flush.
+struct SizedFace {
+  FT_Size size = nullptr;
+  hb_font_t* hbFont = nullptr;
+  uint16_t effectiveSize = 0;
+  uint64_t lastUse = 0;
+  std::unique_ptr<AsciiShapeTable> ascii;
 };
 
 struct GlyphKey {
@@ -89,18 +192,28 @@ struct GlyphKey {
   uint16_t sizePx = 0;
   uint16_t embolden = 0;
   uint32_t glyphId = 0;
+  bool distanceField = false;
+  uint8_t subpixelBin = 0;
 
   bool operator==(GlyphKey const& other) const {
-    return faceId == other.faceId && sizePx == other.sizePx && embolden == other.embolden && glyphId == other.glyphId;
+    return faceId == other.faceId && sizePx == other.sizePx && embolden == other.embolden && glyphId == other.glyphId &&
+           distanceField == other.distanceField && subpixelBin == other.subpixelBin;
   }
 };
 
+struct GlyphMetrics {
+  FT_Pos bearingX = 0;
+  FT_Pos width = 0;
+  bool valid = false;
+};
+
 struct GlyphKeyHash {
   size_t operator()(GlyphKey const& key) const {
     size_t h = static_cast<size_t>(key.faceId);
     h = (h * 1315423911u) ^ static_cast<size_t>(key.sizePx + 0x9e3779b9);
     h = (h * 2654435761u) ^ static_cast<size_t>(key.embolden + 0x85ebca6b);
     h = (h * 2246822519u) ^ static_cast<size_t>(key.glyphId + 0x7f4a7c15);
+    h = (h * 3266489917u) ^ static_cast<size_t>((key.distanceField ? 1u : 0u) | (key.subpixelBin << 1));
     return h;
   }
 };
@@ -112,6 +225,8 @@ static auto fnv1a_hash(uint64_t h, uint64_t v) -> uint64_t {
   return h;
 }
 
+static std::atomic<uint64_t> nextRegistrySerial{1};
+
 static auto to_lower(std::string_view text) -> std::string {
   std::string out{text};
   std::transform(out.begin(), out.end(), out.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
@@ -161,6 +276,22 @@ static auto infer_weight_from_style(std::string_view style) -> std::optional<uin
   return std::nullopt;
 }
 
+static void describe_face(FT_Face face,
+                          std::string const& fallbackName,
+                          std::string& family,
+                          uint16_t& weight,
+                          FontSlant& slant) {
+  family = face->family_name ? face->family_name : fallbackName;
+  weight = resolve_face_weight(face);
+  if (auto styleWeight = infer_weight_from_style(face->style_name ? face->style_name : "")) {
+    if (weight == 0 || weight == 400 ||
+        std::abs(static_cast<int>(weight) - static_cast<int>(*styleWeight)) >= 100) {
+      weight = *styleWeight;
+    }
+  }
+  slant = (face->style_flags & FT_STYLE_FLAG_ITALIC) ? FontSlant::Italic : FontSlant::Upright;
+}
+
 static auto is_word_space(uint32_t codepoint) -> bool {
   switch (codepoint) {
     case 0x20u: // space
@@ -225,11 +356,6 @@ static auto parse_features(std::string const& features) -> std::vector<hb_featur
   return out;
 }
 
-static bool face_supports_glyph(FontFace* face, uint32_t codepoint) {
-  if (!face || !face->face) return false;
-  return FT_Get_Char_Index(face->face, codepoint) != 0;
-}
-
 static void select_unicode_charmap(FT_Face face) {
   if (!face) return;
   if (FT_Select_Charmap(face, FT_ENCODING_UNICODE) == 0) return;
@@ -312,18 +438,490 @@ static void add_default_bundle_dirs(std::vector<std::string>& dirs) {
   }
 }
 
+// One face of an OS font file as recorded in the persisted coverage index. Coverage is stored as
+// sorted 256-codepoint pages, each with a 256-bit mask, so a lookup is a binary search and a bit test.
+struct FontIndexEntry {
+  std::string path;
+  int64_t mtime = 0;
+  uint64_t fileSize = 0;
+  uint32_t faceIndex = 0;
+  std::string family;
+  uint16_t weight = 400;
+  FontSlant slant = FontSlant::Upright;
+  std::vector<uint32_t> pages;
+  std::vector<std::array<uint64_t, 4>> masks;
+
+  bool covers(uint32_t codepoint) const {
+    uint32_t page = codepoint >> 8;
+    auto it = std::lower_bound(pages.begin(), pages.end(), page);
+    if (it == pages.end() || *it != page) return false;
+    auto const& mask = masks[static_cast<size_t>(it - pages.begin())];
+    uint32_t bit = codepoint & 0xFFu;
+    return ((mask[bit >> 6] >> (bit & 63u)) & 1u) != 0u;
+  }
+
+  void add(uint32_t codepoint) {
+    uint32_t page = codepoint >> 8;
+    auto it = std::lower_bound(pages.begin(), pages.end(), page);
+    size_t slot = static_cast<size_t>(it - pages.begin());
+    if (it == pages.end() || *it != page) {
+      pages.insert(it, page);
+      masks.insert(masks.begin() + static_cast<std::ptrdiff_t>(slot), std::array<uint64_t, 4>{});
+    }
+    uint32_t bit = codepoint & 0xFFu;
+    masks[slot][bit >> 6] |= 1ull << (bit & 63u);
+  }
+};
+
+struct FontFileStamp {
+  int64_t mtime = 0;
+  uint64_t size = 0;
+};
+
+static auto stat_font_file(std::string const& path) -> std::optional<FontFileStamp> {
+  std::error_code ec;
+  auto size = std::filesystem::file_size(path, ec);
+  if (ec) return std::nullopt;
+  auto time = std::filesystem::last_write_time(path, ec);
+  if (ec) return std::nullopt;
+  return FontFileStamp{static_cast<int64_t>(time.time_since_epoch().count()), static_cast<uint64_t>(size)};
+}
+
+static void index_font_file(FT_Library library,
+                            std::string const& path,
+                            FontFileStamp stamp,
+                            std::vector<FontIndexEntry>& out) {
+  auto file = MappedFile::open(path);
+  if (!file) return;
+  FT_Long faceCount = 1;
+  for (FT_Long idx = 0; idx < faceCount; ++idx) {
+    FT_Face face = nullptr;
+    if (FT_New_Memory_Face(library,
+                           reinterpret_cast<const FT_Byte*>(file->data),
+                           static_cast<FT_Long>(file->size),
+                           idx,
+                           &face) != 0 || !face) {
+      continue;
+    }
+    faceCount = std::max<FT_Long>(1, face->num_faces);
+    select_unicode_charmap(face);
+    FontIndexEntry entry;
+    entry.path = path;
+    entry.mtime = stamp.mtime;
+    entry.fileSize = stamp.size;
+    entry.faceIndex = static_cast<uint32_t>(idx);
+    describe_face(face, std::filesystem::path(path).stem().string(), entry.family, entry.weight, entry.slant);
+    FT_UInt glyphIndex = 0;
+    FT_ULong codepoint = FT_Get_First_Char(face, &glyphIndex);
+    while (glyphIndex != 0) {
+      if (codepoint <= 0x10FFFFu) entry.add(static_cast<uint32_t>(codepoint));
+      codepoint = FT_Get_Next_Char(face, codepoint, &glyphIndex);
+    }
+    FT_Done_Face(face);
+    out.push_back(std::move(entry));
+  }
+}
+
+// Rescans only files whose (mtime, size) changed since `previous`; everything else is carried over.
+static auto build_font_index(std::vector<std::string> const& dirs,
+                             std::vector<FontIndexEntry> const& previous,
+                             std::atomic<bool> const& cancel) -> std::vector<FontIndexEntry> {
+  std::vector<std::string> files;
+  for (auto const& dir : dirs) {
+    append_font_files(dir, files);
+  }
+  std::sort(files.begin(), files.end());
+  files.erase(std::unique(files.begin(), files.end()), files.end());
+
+  std::unordered_map<std::string, size_t> previousByPath;
+  for (size_t i = previous.size(); i-- > 0;) {
+    previousByPath[previous[i].path] = i;
+  }
+
+  std::vector<FontIndexEntry> out;
+  FT_Library library = nullptr;
+  for (auto const& path : files) {
+    if (cancel.load(std::memory_order_relaxed)) break;
+    auto stamp = stat_font_file(path);
+    if (!stamp) continue;
+    if (auto it = previousByPath.find(path); it != previousByPath.end()) {
+      auto const& first = previous[it->second];
+      if (first.mtime == stamp->mtime && first.fileSize == stamp->size) {
+        for (size_t i = it->second; i < previous.size() && previous[i].path == path; ++i) {
+          out.push_back(previous[i]);
+        }
+        continue;
+      }
+    }
+    if (!library && FT_Init_FreeType(&library) != 0) break;
+    index_font_file(library, path, *stamp, out);
+  }
+  if (library) FT_Done_FreeType(library);
+  return out;
+}
+
+static bool same_font_files(std::vector<FontIndexEntry> const& a, std::vector<FontIndexEntry> const& b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i].path != b[i].path || a[i].faceIndex != b[i].faceIndex ||
+        a[i].mtime != b[i].mtime || a[i].fileSize != b[i].fileSize) {
+      return false;
+    }
+  }
+  return true;
+}
+
+constexpr uint8_t FontIndexMagic[8] = {'P','M','F','I','D','X','\0','\0'};
+constexpr uint32_t FontIndexVersion = 2;
+
+// The OS font dirs an index was built from are stored with it; a registry only trusts an index
+// built from exactly its own dir list.
+struct FontIndexFile {
+  std::vector<std::string> dirs;
+  std::vector<FontIndexEntry> entries;
+};
+
+static auto load_font_index(std::string const& path) -> std::optional<FontIndexFile> {
+  auto file = MappedFile::open(path);
+  if (!file) return std::nullopt;
+  const uint8_t* bytes = file->data;
+  size_t byteCount = file->size;
+  if (byteCount < 16 || std::memcmp(bytes, FontIndexMagic, sizeof(FontIndexMagic)) != 0) {
+    return std::nullopt;
+  }
+
+  size_t cursor = sizeof(FontIndexMagic);
+  auto read = [&](void* out, size_t size) -> bool {
+    if (cursor + size > byteCount) return false;
+    std::memcpy(out, bytes + cursor, size);
+    cursor += size;
+    return true;
+  };
+  auto read_string = [&](std::string& out) -> bool {
+    uint32_t length = 0;
+    if (!read(&length, sizeof(length)) || cursor + length > byteCount) return false;
+    out.assign(reinterpret_cast<const char*>(bytes + cursor), length);
+    cursor += length;
+    return true;
+  };
+
+  uint32_t version = 0;
+  uint32_t dirCount = 0;
+  if (!read(&version, sizeof(version)) || version != FontIndexVersion) return std::nullopt;
+  if (!read(&dirCount, sizeof(dirCount)) || dirCount > byteCount / sizeof(uint32_t)) return std::nullopt;
+  FontIndexFile index;
+  index.dirs.resize(dirCount);
+  for (auto& dir : index.dirs) {
+    if (!read_string(dir)) return std::nullopt;
+  }
+  uint32_t count = 0;
+  if (!read(&count, sizeof(count))) return std::nullopt;
+
+  auto& entries = index.entries;
+  entries.reserve(std::min<size_t>(count, byteCount / 32));
+  for (uint32_t i = 0; i < count; ++i) {
+    FontIndexEntry entry;
+    uint8_t slant = 0;
+    uint32_t pageCount = 0;
+    if (!read_string(entry.path) ||
+        !read(&entry.mtime, sizeof(entry.mtime)) ||
+        !read(&entry.fileSize, sizeof(entry.fileSize)) ||
+        !read(&entry.faceIndex, sizeof(entry.faceIndex)) ||
+        !read_string(entry.family) ||
+        !read(&entry.weight, sizeof(entry.weight)) ||
+        !read(&slant, sizeof(slant)) ||
+        !read(&pageCount, sizeof(pageCount))) {
+      return std::nullopt;
+    }
+    if (cursor + static_cast<size_t>(pageCount) * (sizeof(uint32_t) + sizeof(uint64_t) * 4) > byteCount) {
+      return std::nullopt;
+    }
+    entry.slant = slant != 0 ? FontSlant::Italic : FontSlant::Upright;
+    entry.pages.resize(pageCount);
+    entry.masks.resize(pageCount);
+    for (uint32_t p = 0; p < pageCount; ++p) {
+      read(&entry.pages[p], sizeof(uint32_t));
+      read(entry.masks[p].data(), sizeof(uint64_t) * 4);
+      if (p > 0 && entry.pages[p] <= entry.pages[p - 1]) return std::nullopt;
+    }
+    entries.push_back(std::move(entry));
+  }
+  return index;
+}
+
+static bool save_font_index(std::string const& path,
+                            std::vector<std::string> const& dirs,
+                            std::vector<FontIndexEntry> const& entries) {
+  std::filesystem::path target(path);
+  std::error_code ec;
+  if (target.has_parent_path()) {
+    std::filesystem::create_directories(target.parent_path(), ec);
+  }
+  std::filesystem::path temp = target;
+  temp += ".tmp";
+  {
+    std::ofstream output(temp, std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) return false;
+    auto write = [&](const void* data, size_t size) {
+      output.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+    };
+    auto write_string = [&](std::string const& value) {
+      uint32_t length = static_cast<uint32_t>(value.size());
+      write(&length, sizeof(length));
+      write(value.data(), value.size());
+    };
+    uint32_t dirCount = static_cast<uint32_t>(dirs.size());
+    uint32_t count = static_cast<uint32_t>(entries.size());
+    write(FontIndexMagic, sizeof(FontIndexMagic));
+    write(&FontIndexVersion, sizeof(FontIndexVersion));
+    write(&dirCount, sizeof(dirCount));
+    for (auto const& dir : dirs) {
+      write_string(dir);
+    }
+    write(&count, sizeof(count));
+    for (auto const& entry : entries) {
+      uint8_t slant = entry.slant == FontSlant::Italic ? 1u : 0u;
+      uint32_t pageCount = static_cast<uint32_t>(entry.pages.size());
+      write_string(entry.path);
+      write(&entry.mtime, sizeof(entry.mtime));
+      write(&entry.fileSize, sizeof(entry.fileSize));
+      write(&entry.faceIndex, sizeof(entry.faceIndex));
+      write_string(entry.family);
+      write(&entry.weight, sizeof(entry.weight));
+      write(&slant, sizeof(slant));
+      write(&pageCount, sizeof(pageCount));
+      for (size_t p = 0; p < entry.pages.size(); ++p) {
+        write(&entry.pages[p], sizeof(uint32_t));
+        write(entry.masks[p].data(), sizeof(uint64_t) * 4);
+      }
+    }
+    if (!output) return false;
+  }
+  std::filesystem::rename(temp, target, ec);
+  if (ec) {
+    std::filesystem::remove(temp, ec);
+    return false;
+  }
+  return true;
+}
+
+static auto default_font_index_path() -> std::string {
+  if (auto* env = std::getenv("PRIMEMANIFEST_FONT_INDEX")) return env;
+#if defined(_WIN32)
+  if (auto* local = std::getenv("LOCALAPPDATA")) {
+    return (std::filesystem::path(local) / "PrimeManifest" / "os-font-index.bin").string();
+  }
+#elif defined(__APPLE__)
+  if (auto* home = std::getenv("HOME")) {
+    return (std::filesystem::path(home) / "Library/Caches/PrimeManifest/os-font-index.bin").string();
+  }
+#else
+  if (auto* cache = std::getenv("XDG_CACHE_HOME"); cache && *cache) {
+    return (std::filesystem::path(cache) / "primemanifest" / "os-font-index.bin").string();
+  }
+  if (auto* home = std::getenv("HOME")) {
+    return (std::filesystem::path(home) / ".cache/primemanifest/os-font-index.bin").string();
+  }
+#endif
+  return {};
+}
+
+static auto rasterize_distance_field_glyph(FT_Face face, GlyphKey const& key) -> std::unique_ptr<GlyphBitmap> {
+  if (FT_Load_Glyph(face, key.glyphId, FT_LOAD_DEFAULT | FT_LOAD_NO_HINTING) != 0) return nullptr;
+  if (key.embolden > 0 && face->glyph->format == FT_GLYPH_FORMAT_OUTLINE) {
+    FT_Outline_Embolden(&face->glyph->outline, static_cast<FT_Pos>(key.embolden));
+  }
+  if (face->glyph->format != FT_GLYPH_FORMAT_BITMAP) {
+    if (FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL) != 0) return nullptr;
+  }
+
+  FT_GlyphSlot slot = face->glyph;
+  FT_Bitmap& bm = slot->bitmap;
+
+  auto bitmap = std::make_unique<GlyphBitmap>();
+  bitmap->format = GlyphBitmapFormat::Sdf8;
+  bitmap->advance = static_cast<int>(slot->advance.x / 64);
+  if (bm.buffer && bm.width > 0 && bm.rows > 0) {
+    FontBitmapView view;
+    view.buffer = bm.buffer;
+    view.width = static_cast<int32_t>(bm.width);
+    view.height = static_cast<int32_t>(bm.rows);
+    view.pitch = bm.pitch;
+    switch (bm.pixel_mode) {
+      case FT_PIXEL_MODE_MONO: view.format = FontBitmapFormat::Mono1; break;
+      case FT_PIXEL_MODE_BGRA: view.format = FontBitmapFormat::BGRA32; break;
+      default: view.format = FontBitmapFormat::Gray8; break;
+    }
+    std::vector<uint8_t> coverage;
+    int32_t coverageStride = 0;
+    if (!ConvertFontBitmapToAlpha(view, coverage, coverageStride)) return nullptr;
+    if (!BuildGlyphDistanceField(coverage.data(),
+                                 view.width,
+                                 view.height,
+                                 coverageStride,
+                                 GlyphSdfSpread,
+                                 bitmap->pixels,
+                                 bitmap->width,
+                                 bitmap->height)) {
+      return nullptr;
+    }
+    bitmap->stride = bitmap->width;
+    bitmap->bearingX = slot->bitmap_left - GlyphSdfSpread;
+    bitmap->bearingY = slot->bitmap_top + GlyphSdfSpread;
+  }
+  return bitmap;
+}
+
+// Rasterizes one glyph on a face already sized for key.sizePx. Mask8 pixels come back unplaced
+// (owned, stride == width); atlas placement happens when the glyph is stored in the cache.
+static auto rasterize_glyph(FT_Face face, GlyphKey const& key) -> std::unique_ptr<GlyphBitmap> {
+  if (key.distanceField) return rasterize_distance_field_glyph(face, key);
+  FT_Int32 loadFlags = FT_LOAD_DEFAULT | FT_LOAD_COLOR;
+  if (FT_Load_Glyph(face, key.glyphId, loadFlags) != 0) return nullptr;
+  if (key.embolden > 0 && face->glyph->format == FT_GLYPH_FORMAT_OUTLINE) {
+    FT_Outline_Embolden(&face->glyph->outline, static_cast<FT_Pos>(key.embolden));
+  }
+  bool shifted = false;
+  if (key.subpixelBin > 0 && face->glyph->format == FT_GLYPH_FORMAT_OUTLINE) {
+    FT_Outline_Translate(&face->glyph->outline, static_cast<FT_Pos>(key.subpixelBin) * 64 / GlyphSubpixelBins, 0);
+    shifted = true;
+  }
+  if (face->glyph->format != FT_GLYPH_FORMAT_BITMAP) {
+    if (FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL) != 0) return nullptr;
+  }
+
+  FT_GlyphSlot slot = face->glyph;
+  FT_Bitmap& bm = slot->bitmap;
+
+  auto bitmap = std::make_unique<GlyphBitmap>();
+  bitmap->width = static_cast<int>(bm.width);
+  bitmap->height = static_cast<int>(bm.rows);
+  bitmap->bearingX = slot->bitmap_left;
+  bitmap->bearingY = slot->bitmap_top;
+  bitmap->advance = static_cast<int>(slot->advance.x / 64);
+  bitmap->subpixelBin = shifted ? key.subpixelBin : 0u;
+  if (bm.buffer && bitmap->width > 0 && bitmap->height > 0) {
+    if (bm.pixel_mode == FT_PIXEL_MODE_BGRA) {
+      bitmap->format = GlyphBitmapFormat::ColorBGRA;
+      bitmap->stride = bitmap->width * 4;
+      bitmap->pixels.resize(static_cast<size_t>(bitmap->stride) * bitmap->height);
+      int pitch = bm.pitch;
+      for (int y = 0; y < bitmap->height; ++y) {
+        const uint8_t* srcRow = bm.buffer + (pitch >= 0 ? y * pitch : (bitmap->height - 1 - y) * -pitch);
+        uint8_t* dstRow = bitmap->pixels.data() + static_cast<size_t>(y) * bitmap->stride;
+        std::memcpy(dstRow, srcRow, static_cast<size_t>(bitmap->stride));
+      }
+    } else {
+      FontBitmapView view;
+      view.buffer = bm.buffer;
+      view.width = bitmap->width;
+      view.height = bitmap->height;
+      view.pitch = bm.pitch;
+      view.format = bm.pixel_mode == FT_PIXEL_MODE_MONO ? FontBitmapFormat::Mono1 : FontBitmapFormat::Gray8;
+
+      int32_t convertedStride = 0;
+      if (!ConvertFontBitmapToAlpha(view, bitmap->pixels, convertedStride)) return nullptr;
+      bitmap->format = GlyphBitmapFormat::Mask8;
+      bitmap->stride = convertedStride;
+    }
+  }
+  return bitmap;
+}
+
+struct GlyphRequest {
+  FontFace* face = nullptr;
+  GlyphKey key;
+};
+
+// Each worker opens its own FT_Library and FT_Face instances over the faces' shared font memory,
+// so rasterization runs without the registry lock. Results line up with `requests`.
+static auto rasterize_glyphs_parallel(std::vector<GlyphRequest> const& requests)
+    -> std::vector<std::unique_ptr<GlyphBitmap>> {
+  std::vector<std::unique_ptr<GlyphBitmap>> out(requests.size());
+  if (requests.empty()) return out;
+  constexpr size_t Batch = 16;
+  size_t batches = (requests.size() + Batch - 1) / Batch;
+  uint32_t workerCount = std::max(1u, std::thread::hardware_concurrency());
+  workerCount = static_cast<uint32_t>(std::min<size_t>(workerCount, batches));
+  std::atomic<size_t> next{0};
+
+  auto work = [&]() {
+    FT_Library library = nullptr;
+    if (FT_Init_FreeType(&library) != 0) return;
+    std::unordered_map<FontFace const*, FT_Face> opened;
+    FT_Face sizedFace = nullptr;
+    uint16_t sizedPx = 0;
+    for (;;) {
+      size_t begin = next.fetch_add(Batch, std::memory_order_relaxed);
+      if (begin >= requests.size()) break;
+      size_t end = std::min(begin + Batch, requests.size());
+      for (size_t i = begin; i < end; ++i) {
+        GlyphRequest const& request = requests[i];
+        auto [it, inserted] = opened.try_emplace(request.face, nullptr);
+        if (inserted) {
+          FontBuffer const& source = request.face->source;
+          FT_Face face = nullptr;
+          if (source.data &&
+              FT_New_Memory_Face(library,
+                                 reinterpret_cast<const FT_Byte*>(source.data),
+                                 static_cast<FT_Long>(source.size),
+                                 request.face->faceIndex,
+                                 &face) == 0) {
+            select_unicode_charmap(face);
+            it->second = face;
+          }
+        }
+        FT_Face face = it->second;
+        if (!face) continue;
+        if (face != sizedFace || sizedPx != request.key.sizePx) {
+          sizedFace = nullptr;
+          if (set_face_pixel_size(face, request.key.sizePx) == 0) continue;
+          sizedFace = face;
+          sizedPx = request.key.sizePx;
+        }
+        out[i] = rasterize_glyph(face, request.key);
+      }
+    }
+    for (auto& [owner, face] : opened) {
+      if (face) FT_Done_Face(face);
+    }
+    FT_Done_FreeType(library);
+  };
+
+  std::vector<std::thread> workers;
+  workers.reserve(workerCount - 1u);
+  for (uint32_t i = 1; i < workerCount; ++i) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  return out;
+}
+
 } // namespace
 
 struct FontRegistry::Impl {
   FT_Library ftLibrary = nullptr;
+  uint64_t serial = nextRegistrySerial.fetch_add(1);
   uint32_t nextFaceId = 1;
   std::vector<std::unique_ptr<FontFace>> faces;
   std::vector<FontFace*> bundledFaces;
   std::vector<FontFace*> osFaces;
   std::unordered_map<GlyphKey, std::unique_ptr<GlyphBitmap>, GlyphKeyHash> glyphCache;
-  std::unordered_map<uint64_t, FontFace*> fallbackCache;
+  std::unordered_map<GlyphKey, GlyphMetrics, GlyphKeyHash> glyphMetricsCache;
+  hb_buffer_t* shapeBuffer = nullptr;
+  std::unordered_map<uint64_t, FallbackTable> fallbackTables;
+  std::unordered_map<uint64_t, SizedFace> sizedFaces;
+  uint64_t sizedFaceClock = 0;
+  bool latinFastPath = true;
+  bool mapFontFiles = true;
+  std::vector<Utf8Codepoint> codepointScratch;
+  std::vector<hb_glyph_info_t> asciiInfos;
+  std::vector<hb_glyph_position_t> asciiPositions;
+  std::vector<GlyphRequest>* glyphRequests = nullptr;
   std::vector<std::shared_ptr<GlyphAtlas>> atlases;
-  std::vector<FontBuffer> bundleBuffers;
   std::vector<std::string> bundleDirs;
   std::vector<std::string> osFontDirs;
   std::vector<std::string> osFontFiles;
@@ -334,6 +932,20 @@ struct FontRegistry::Impl {
   size_t atlasMax = 0;
   std::mutex mutex;
 
+  std::string fontIndexPath = default_font_index_path();
+  std::vector<FontIndexEntry> fontIndex;
+  std::vector<std::string> fontIndexDirs;
+  bool fontIndexReady = false;
+  bool fontIndexLoaded = false;
+  bool fontIndexRefreshed = false;
+  std::unordered_map<std::string, FontFace*> indexedFaces;
+  std::thread fontIndexThread;
+  std::atomic<bool> fontIndexCancel{false};
+  std::mutex fontIndexMutex;
+  bool fontIndexBuilding = false;
+  std::optional<FontIndexFile> fontIndexBuilt;
+
+  static constexpr size_t SizedFaceCapacity = 64;
   static constexpr int AtlasWidth = 1024;
   static constexpr int AtlasHeight = 1024;
 
@@ -343,40 +955,56 @@ struct FontRegistry::Impl {
     add_default_os_font_dirs(osFontDirs);
   }
   ~Impl() {
+    fontIndexCancel.store(true, std::memory_order_relaxed);
+    if (fontIndexThread.joinable()) fontIndexThread.join();
+    if (shapeBuffer) hb_buffer_destroy(shapeBuffer);
+    for (auto& [key, sized] : sizedFaces) {
+      if (sized.hbFont) hb_font_destroy(sized.hbFont);
+    }
     for (auto &face : faces) {
-      if (face->hbFont) hb_font_destroy(face->hbFont);
       if (face->face) FT_Done_Face(face->face);
     }
     if (ftLibrary) FT_Done_FreeType(ftLibrary);
   }
 
   void loadFaceFile(std::string const& path, bool fromBundle) {
+    auto file = MappedFile::open(path, mapFontFiles);
+    if (!file) return;
+    FontBuffer buffer;
+    buffer.file = file;
+    buffer.data = file->data;
+    buffer.size = file->size;
+    loadFaceMemory(buffer, fromBundle);
+  }
+
+  void loadFaceMemory(FontBuffer const& buffer, bool fromBundle) {
+    if (!buffer.data || buffer.size == 0) return;
     FT_Face face = nullptr;
-    if (FT_New_Face(ftLibrary, path.c_str(), 0, &face) != 0 || !face) {
+    if (FT_New_Memory_Face(ftLibrary,
+                           reinterpret_cast<const FT_Byte*>(buffer.data),
+                           static_cast<FT_Long>(buffer.size),
+                           0,
+                           &face) != 0 || !face) {
       return;
     }
     int faceCount = face->num_faces;
     FT_Done_Face(face);
     for (int idx = 0; idx < std::max(1, faceCount); ++idx) {
       FT_Face f = nullptr;
-      if (FT_New_Face(ftLibrary, path.c_str(), idx, &f) != 0 || !f) {
+      if (FT_New_Memory_Face(ftLibrary,
+                             reinterpret_cast<const FT_Byte*>(buffer.data),
+                             static_cast<FT_Long>(buffer.size),
+                             idx,
+                             &f) != 0 || !f) {
         continue;
       }
-      select_unicode_charmap(f);
       auto entry = std::make_unique<FontFace>();
       entry->id = nextFaceId++;
-      entry->family = f->family_name ? f->family_name : "";
-      entry->weight = resolve_face_weight(f);
-      if (auto styleWeight = infer_weight_from_style(f->style_name ? f->style_name : "")) {
-        if (entry->weight == 0 || entry->weight == 400 ||
-            std::abs(static_cast<int>(entry->weight) - static_cast<int>(*styleWeight)) >= 100) {
-          entry->weight = *styleWeight;
-        }
-      }
-      entry->slant = (f->style_flags & FT_STYLE_FLAG_ITALIC) ? FontSlant::Italic : FontSlant::Upright;
-      entry->face = f;
-      entry->hbFont = hb_ft_font_create_referenced(f);
+      describe_face(f, buffer.name, entry->family, entry->weight, entry->slant);
       entry->fromBundle = fromBundle;
+      entry->source = buffer;
+      entry->faceIndex = idx;
+      FT_Done_Face(f);
 
       FontFace* ptr = entry.get();
       faces.push_back(std::move(entry));
@@ -388,73 +1016,171 @@ struct FontRegistry::Impl {
     }
   }
 
-  void loadFaceMemory(FontBuffer const& buffer, bool fromBundle) {
-    if (buffer.data.empty()) return;
-    FT_Face face = nullptr;
+  bool ensureFace(FontFace* face) {
+    if (!face) return false;
+    if (face->face) return true;
+    if (face->openFailed || !face->source.data) return false;
+    FT_Face f = nullptr;
     if (FT_New_Memory_Face(ftLibrary,
-                           reinterpret_cast<const FT_Byte*>(buffer.data.data()),
-                           static_cast<FT_Long>(buffer.data.size()),
-                           0,
-                           &face) != 0 || !face) {
-      return;
+                           reinterpret_cast<const FT_Byte*>(face->source.data),
+                           static_cast<FT_Long>(face->source.size),
+                           face->faceIndex,
+                           &f) != 0 || !f) {
+      face->openFailed = true;
+      return false;
     }
-    int faceCount = face->num_faces;
-    FT_Done_Face(face);
-    for (int idx = 0; idx < std::max(1, faceCount); ++idx) {
-      FT_Face f = nullptr;
-      if (FT_New_Memory_Face(ftLibrary,
-                             reinterpret_cast<const FT_Byte*>(buffer.data.data()),
-                             static_cast<FT_Long>(buffer.data.size()),
-                             idx,
-                             &f) != 0 || !f) {
+    select_unicode_charmap(f);
+    face->face = f;
+    return true;
+  }
+
+  SizedFace* activateSize(FontFace* face, uint16_t sizePx) {
+    if (!face || !face->face || sizePx == 0) return nullptr;
+    uint64_t key = (static_cast<uint64_t>(face->id) << 16) | sizePx;
+    auto it = sizedFaces.find(key);
+    if (it == sizedFaces.end()) {
+      if (sizedFaces.size() >= SizedFaceCapacity) evictSizedFace();
+      FT_Size size = nullptr;
+      if (FT_New_Size(face->face, &size) != 0 || !size) return nullptr;
+      FT_Activate_Size(size);
+      uint16_t effectiveSize = set_face_pixel_size(face->face, sizePx);
+      if (effectiveSize == 0) {
+        FT_Done_Size(size);
+        return nullptr;
+      }
+      SizedFace sized;
+      sized.size = size;
+      sized.effectiveSize = effectiveSize;
+      sized.hbFont = hb_ft_font_create_referenced(face->face);
+      if (sized.hbFont) hb_ft_font_set_load_flags(sized.hbFont, FT_LOAD_DEFAULT);
+      it = sizedFaces.emplace(key, std::move(sized)).first;
+    } else if (face->face->size != it->second.size) {
+      FT_Activate_Size(it->second.size);
+    }
+    it->second.lastUse = ++sizedFaceClock;
+    return &it->second;
+  }
+
+  hb_buffer_t* shapeLatin(hb_font_t* font, char const* text, int length) {
+    if (!shapeBuffer) shapeBuffer = hb_buffer_create();
+    hb_buffer_clear_contents(shapeBuffer);
+    hb_buffer_add_utf8(shapeBuffer, text, length, 0, length);
+    hb_buffer_set_direction(shapeBuffer, HB_DIRECTION_LTR);
+    hb_buffer_set_script(shapeBuffer, HB_SCRIPT_LATIN);
+    hb_buffer_guess_segment_properties(shapeBuffer);
+    hb_shape(font, shapeBuffer, nullptr, 0);
+    return shapeBuffer;
+  }
+
+  AsciiShapeTable& asciiTable(SizedFace& sized) {
+    if (sized.ascii) return *sized.ascii;
+    sized.ascii = std::make_unique<AsciiShapeTable>();
+    AsciiShapeTable& table = *sized.ascii;
+    table.kern.assign(static_cast<size_t>(AsciiShapeTable::Count) * AsciiShapeTable::Count, AsciiShapeTable::Complex);
+    for (uint32_t c = 0; c < AsciiShapeTable::Count; ++c) {
+      char ch = static_cast<char>(AsciiShapeTable::First + c);
+      hb_buffer_t* buffer = shapeLatin(sized.hbFont, &ch, 1);
+      unsigned int count = 0;
+      hb_glyph_info_t* infos = hb_buffer_get_glyph_infos(buffer, &count);
+      hb_glyph_position_t* positions = hb_buffer_get_glyph_positions(buffer, &count);
+      if (count != 1 || positions[0].x_offset != 0 || positions[0].y_offset != 0 || positions[0].y_advance != 0) {
         continue;
       }
-      select_unicode_charmap(f);
-      auto entry = std::make_unique<FontFace>();
-      entry->id = nextFaceId++;
-      entry->family = f->family_name ? f->family_name : buffer.name;
-      entry->weight = resolve_face_weight(f);
-      if (auto styleWeight = infer_weight_from_style(f->style_name ? f->style_name : "")) {
-        if (entry->weight == 0 || entry->weight == 400 ||
-            std::abs(static_cast<int>(entry->weight) - static_cast<int>(*styleWeight)) >= 100) {
-          entry->weight = *styleWeight;
-        }
+      table.glyph[c] = infos[0].codepoint;
+      table.advance[c] = positions[0].x_advance;
+      table.simple[c] = true;
+    }
+    return table;
+  }
+
+  // Kerning against every right-hand character, learned by shaping each pair once. Pairs that
+  // substitute glyphs or move the second glyph stay Complex and send the text through hb_shape.
+  void buildAsciiKernRow(SizedFace& sized, AsciiShapeTable& table, uint32_t left) {
+    table.rowBuilt[left] = true;
+    if (!table.simple[left]) return;
+    for (uint32_t right = 0; right < AsciiShapeTable::Count; ++right) {
+      if (!table.simple[right]) continue;
+      char pair[2] = {static_cast<char>(AsciiShapeTable::First + left), static_cast<char>(AsciiShapeTable::First + right)};
+      hb_buffer_t* buffer = shapeLatin(sized.hbFont, pair, 2);
+      unsigned int count = 0;
+      hb_glyph_info_t* infos = hb_buffer_get_glyph_infos(buffer, &count);
+      hb_glyph_position_t* positions = hb_buffer_get_glyph_positions(buffer, &count);
+      if (count != 2 || infos[0].codepoint != table.glyph[left] || infos[1].codepoint != table.glyph[right] ||
+          positions[0].x_offset != 0 || positions[0].y_offset != 0 || positions[0].y_advance != 0 ||
+          positions[1].x_offset != 0 || positions[1].y_offset != 0 || positions[1].y_advance != 0 ||
+          positions[1].x_advance != table.advance[right]) {
+        continue;
       }
-      entry->slant = (f->style_flags & FT_STYLE_FLAG_ITALIC) ? FontSlant::Italic : FontSlant::Upright;
-      entry->face = f;
-      entry->hbFont = hb_ft_font_create_referenced(f);
-      entry->fromBundle = fromBundle;
+      table.kern[static_cast<size_t>(left) * AsciiShapeTable::Count + right] = positions[0].x_advance - table.advance[left];
+    }
+  }
 
-      FontFace* ptr = entry.get();
-      faces.push_back(std::move(entry));
-      if (fromBundle) {
-        bundledFaces.push_back(ptr);
-      } else {
-        osFaces.push_back(ptr);
+  // Fills asciiInfos/asciiPositions exactly as hb_shape would for printable ASCII Latin text.
+  bool shapeAscii(SizedFace& sized, std::string_view text) {
+    if (text.empty()) return false;
+    bool hasLetter = false;
+    for (char ch : text) {
+      unsigned char c = static_cast<unsigned char>(ch);
+      if (c < AsciiShapeTable::First || c >= AsciiShapeTable::First + AsciiShapeTable::Count) return false;
+      hasLetter = hasLetter || std::isalpha(c) != 0;
+    }
+    if (!hasLetter) return false;
+
+    AsciiShapeTable& table = asciiTable(sized);
+    asciiInfos.resize(text.size());
+    asciiPositions.resize(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+      uint32_t c = static_cast<unsigned char>(text[i]) - AsciiShapeTable::First;
+      if (!table.simple[c]) return false;
+      int32_t advance = table.advance[c];
+      if (i + 1 < text.size()) {
+        uint32_t next = static_cast<unsigned char>(text[i + 1]) - AsciiShapeTable::First;
+        if (!table.rowBuilt[c]) buildAsciiKernRow(sized, table, c);
+        int32_t kern = table.kern[static_cast<size_t>(c) * AsciiShapeTable::Count + next];
+        if (kern == AsciiShapeTable::Complex) return false;
+        advance += kern;
       }
+      hb_glyph_info_t info{};
+      info.codepoint = table.glyph[c];
+      info.cluster = static_cast<uint32_t>(i);
+      hb_glyph_position_t position{};
+      position.x_advance = advance;
+      asciiInfos[i] = info;
+      asciiPositions[i] = position;
     }
+    return true;
+  }
+
+  void evictSizedFace() {
+    auto victim = sizedFaces.end();
+    for (auto it = sizedFaces.begin(); it != sizedFaces.end(); ++it) {
+      if (victim == sizedFaces.end() || it->second.lastUse < victim->second.lastUse) victim = it;
+    }
+    if (victim == sizedFaces.end()) return;
+    if (victim->second.hbFont) hb_font_destroy(victim->second.hbFont);
+    FT_Done_Size(victim->second.size);
+    sizedFaces.erase(victim);
+  }
+
+  bool faceSupportsGlyph(FontFace* face, uint32_t codepoint) {
+    if (!ensureFace(face)) return false;
+    return FT_Get_Char_Index(face->face, codepoint) != 0;
   }
 
   bool loadFontBundle(std::string const& path) {
-    std::ifstream file(path, std::ios::binary);
-    if (!file.is_open()) return false;
-    file.seekg(0, std::ios::end);
-    std::streamoff size = file.tellg();
-    if (size <= 0) return false;
-    file.seekg(0, std::ios::beg);
-
-    std::vector<uint8_t> bytes(static_cast<size_t>(size));
-    file.read(reinterpret_cast<char*>(bytes.data()), size);
+    auto file = MappedFile::open(path, mapFontFiles);
     if (!file) return false;
+    const uint8_t* bytes = file->data;
+    size_t byteCount = file->size;
 
     constexpr uint8_t kMagic[8] = {'P','S','O','S','F','N','T','\0'};
-    if (bytes.size() < 16 || std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) != 0) {
+    if (byteCount < 16 || std::memcmp(bytes, kMagic, sizeof(kMagic)) != 0) {
       return false;
     }
 
     auto read_u32 = [&](size_t &cursor, uint32_t &out) -> bool {
-      if (cursor + 4 > bytes.size()) return false;
-      std::memcpy(&out, bytes.data() + cursor, 4);
+      if (cursor + 4 > byteCount) return false;
+      std::memcpy(&out, bytes + cursor, 4);
       cursor += 4;
       return true;
     };
@@ -469,19 +1195,17 @@ struct FontRegistry::Impl {
       uint32_t nameLen = 0;
       uint32_t dataLen = 0;
       if (!read_u32(cursor, nameLen) || !read_u32(cursor, dataLen)) return false;
-      if (cursor + nameLen + dataLen > bytes.size()) return false;
-      std::string name;
+      if (cursor + nameLen + dataLen > byteCount) return false;
+      FontBuffer buffer;
       if (nameLen > 0) {
-        name.assign(reinterpret_cast<const char*>(bytes.data() + cursor), nameLen);
+        buffer.name.assign(reinterpret_cast<const char*>(bytes + cursor), nameLen);
         cursor += nameLen;
       }
-      FontBuffer buffer;
-      buffer.name = name;
-      buffer.data.assign(bytes.begin() + static_cast<long>(cursor),
-                         bytes.begin() + static_cast<long>(cursor + dataLen));
+      buffer.file = file;
+      buffer.data = bytes + cursor;
+      buffer.size = dataLen;
       cursor += dataLen;
-      bundleBuffers.push_back(std::move(buffer));
-      loadFaceMemory(bundleBuffers.back(), /*fromBundle=*/true);
+      loadFaceMemory(buffer, /*fromBundle=*/true);
     }
     return true;
   }
@@ -531,7 +1255,119 @@ struct FontRegistry::Impl {
     return nullptr;
   }
 
+  // The OS coverage index is read from disk on first use and refreshed on a background thread.
+  // Returns true once it was built from exactly the current OS font dirs; until then fallback keeps
+  // scanning files in order.
+  bool syncFontIndex() {
+    if (osFontDirs.empty()) return false;
+    bool building = false;
+    {
+      std::lock_guard<std::mutex> lock(fontIndexMutex);
+      if (fontIndexBuilt) {
+        fontIndex = std::move(fontIndexBuilt->entries);
+        fontIndexDirs = std::move(fontIndexBuilt->dirs);
+        fontIndexBuilt.reset();
+        fontIndexReady = true;
+      }
+      building = fontIndexBuilding;
+    }
+    if (!fontIndexLoaded) {
+      fontIndexLoaded = true;
+      if (!fontIndexPath.empty()) {
+        if (auto loaded = load_font_index(fontIndexPath)) {
+          fontIndex = std::move(loaded->entries);
+          fontIndexDirs = std::move(loaded->dirs);
+          fontIndexReady = true;
+        }
+      }
+    }
+    if (!building && (!fontIndexRefreshed || fontIndexDirs != osFontDirs)) {
+      startFontIndexBuild();
+    }
+    return fontIndexReady && fontIndexDirs == osFontDirs;
+  }
+
+  void startFontIndexBuild() {
+    if (fontIndexThread.joinable()) fontIndexThread.join();
+    fontIndexRefreshed = true;
+    {
+      std::lock_guard<std::mutex> lock(fontIndexMutex);
+      fontIndexBuilding = true;
+    }
+    fontIndexThread = std::thread([this, dirs = osFontDirs, previousDirs = fontIndexDirs, previous = fontIndex,
+                                   path = fontIndexPath]() {
+      auto built = build_font_index(dirs, previous, fontIndexCancel);
+      bool cancelled = fontIndexCancel.load(std::memory_order_relaxed);
+      if (!cancelled && !path.empty() && (dirs != previousDirs || !same_font_files(built, previous))) {
+        save_font_index(path, dirs, built);
+      }
+      std::lock_guard<std::mutex> lock(fontIndexMutex);
+      if (!cancelled) {
+        fontIndexBuilt = FontIndexFile{dirs, std::move(built)};
+      }
+      fontIndexBuilding = false;
+    });
+  }
+
+  size_t waitForFontIndex(std::unique_lock<std::mutex>& lock) {
+    syncFontIndex();
+    std::thread pending = std::move(fontIndexThread);
+    lock.unlock();
+    if (pending.joinable()) pending.join();
+    lock.lock();
+    syncFontIndex();
+    return fontIndexReady ? fontIndex.size() : 0;
+  }
+
+  // Opens exactly the one file an index entry points at, provided it has not changed on disk.
+  FontFace* openIndexedFace(FontIndexEntry const& entry) {
+    std::string key = entry.path + '\n' + std::to_string(entry.faceIndex) + '\n' + std::to_string(entry.mtime);
+    if (auto it = indexedFaces.find(key); it != indexedFaces.end()) return it->second;
+    FontFace* result = nullptr;
+    auto stamp = stat_font_file(entry.path);
+    if (stamp && stamp->mtime == entry.mtime && stamp->size == entry.fileSize) {
+      if (auto file = MappedFile::open(entry.path, mapFontFiles)) {
+        auto face = std::make_unique<FontFace>();
+        face->id = nextFaceId++;
+        face->family = entry.family;
+        face->weight = entry.weight;
+        face->slant = entry.slant;
+        face->source.file = file;
+        face->source.data = file->data;
+        face->source.size = file->size;
+        face->faceIndex = static_cast<FT_Long>(entry.faceIndex);
+        if (ensureFace(face.get())) {
+          result = face.get();
+          faces.push_back(std::move(face));
+          osFaces.push_back(result);
+        }
+      }
+    }
+    indexedFaces[key] = result;
+    return result;
+  }
+
+  FontFace* pickIndexedFace(std::string const& target, Typography const& typography) {
+    FontIndexEntry const* best = nullptr;
+    int bestScore = std::numeric_limits<int>::max();
+    for (auto const& entry : fontIndex) {
+      if (!target.empty() && target != "default" && to_lower(entry.family) != target) continue;
+      int score = std::abs(static_cast<int>(entry.weight) - static_cast<int>(typography.weight));
+      if (entry.slant != typography.slant) score += 500;
+      if (score < bestScore) {
+        bestScore = score;
+        best = &entry;
+      }
+    }
+    return best ? openIndexedFace(*best) : nullptr;
+  }
+
   FontFace* selectPrimaryFace(Typography const& typography) {
+    FontFace* face = pickPrimaryFace(typography);
+    return ensureFace(face) ? face : nullptr;
+  }
+
+  FontFace* pickPrimaryFace(Typography const& typography) {
     loadBundledFonts();
     std::string target = to_lower(typography.family);
     if (target == "bitmap") return nullptr;
@@ -552,65 +1388,124 @@ struct FontRegistry::Impl {
       return best;
     };
 
+    auto pick_os = [&]() -> FontFace* {
+      // An indexed entry can fail to open when its file changed since indexing; scan files instead.
+      if (syncFontIndex()) {
+        if (auto* face = pickIndexedFace(target, typography)) return face;
+      }
+      loadOsFallbackFonts();
+      while (true) {
+        if (auto* best = pick_best(osFaces)) return best;
+        if (!loadNextOsFallbackFace()) break;
+      }
+      return nullptr;
+    };
+
     if (target.empty() || target == "default") {
       if (!bundledFaces.empty()) return bundledFaces.front();
-      if (typography.fallback == FontFallbackPolicy::BundleThenOS) {
-        loadOsFallbackFonts();
-        while (true) {
-          if (auto* best = pick_best(osFaces)) return best;
-          if (!loadNextOsFallbackFace()) break;
-        }
-      }
+      if (typography.fallback == FontFallbackPolicy::BundleThenOS) return pick_os();
       return nullptr;
     }
 
     if (auto* best = pick_best(bundledFaces)) return best;
     if (typography.fallback == FontFallbackPolicy::BundleThenOS) {
-      loadOsFallbackFonts();
-      while (true) {
-        if (auto* best = pick_best(osFaces)) return best;
-        if (!loadNextOsFallbackFace()) break;
-      }
+      if (auto* best = pick_os()) return best;
     }
     if (!bundledFaces.empty()) return bundledFaces.front();
     if (!osFaces.empty()) return osFaces.front();
     return nullptr;
   }
 
-  FontFace* resolveFaceForCodepoint(uint32_t codepoint,
-                                    FontFace* primary,
-                                    FontFallbackPolicy policy) {
-    if (primary && face_supports_glyph(primary, codepoint)) return primary;
+  FallbackTable& fallbackTableFor(FontFace* primary, FontFallbackPolicy policy) {
+    uint64_t key = (static_cast<uint64_t>(primary ? primary->id : 0) << 1) |
+                   (policy == FontFallbackPolicy::BundleOnly ? 1u : 0u);
+    auto [it, inserted] = fallbackTables.try_emplace(key);
+    FallbackTable& table = it->second;
+    if (inserted) {
+      table.faces.push_back(primary);
+      table.blockPages.assign(FallbackTable::BlockCount, 0u);
+    }
+    return table;
+  }
 
-    uint64_t cacheKey = (static_cast<uint64_t>(primary ? primary->id : 0) << 32) | codepoint;
-    auto it = fallbackCache.find(cacheKey);
-    if (it != fallbackCache.end()) return it->second;
+  uint16_t fallbackSlot(FallbackTable& table, FontFace* face) {
+    for (size_t i = 0; i < table.faces.size(); ++i) {
+      if (table.faces[i] == face) return static_cast<uint16_t>(i);
+    }
+    if (table.faces.size() >= FallbackTable::Unresolved) return 0;
+    table.faces.push_back(face);
+    return static_cast<uint16_t>(table.faces.size() - 1);
+  }
 
-    for (auto* face : bundledFaces) {
-      if (face == primary) continue;
-      if (face_supports_glyph(face, codepoint)) {
-        fallbackCache[cacheKey] = face;
-        return face;
+  void fillPageFromCmap(FallbackTable& table, std::array<uint16_t, 256>& page, uint32_t block, FontFace* face) {
+    if (!ensureFace(face)) return;
+    uint16_t slot = FallbackTable::Unresolved;
+    FT_UInt glyphIndex = 0;
+    FT_ULong blockStart = static_cast<FT_ULong>(block) << 8;
+    FT_ULong codepoint = blockStart == 0 ? FT_Get_First_Char(face->face, &glyphIndex)
+                                         : FT_Get_Next_Char(face->face, blockStart - 1, &glyphIndex);
+    while (glyphIndex != 0 && codepoint < blockStart + 256u) {
+      uint16_t& entry = page[codepoint & 0xFFu];
+      if (entry == FallbackTable::Unresolved) {
+        if (slot == FallbackTable::Unresolved) slot = fallbackSlot(table, face);
+        entry = slot;
       }
+      codepoint = FT_Get_Next_Char(face->face, codepoint, &glyphIndex);
     }
+  }
 
+  uint16_t buildFallbackPage(FallbackTable& table, uint32_t block, FontFallbackPolicy policy) {
+    std::array<uint16_t, 256> page;
+    page.fill(FallbackTable::Unresolved);
+    FontFace* primary = table.faces.front();
+    if (primary) fillPageFromCmap(table, page, block, primary);
+    auto has_gaps = [&]() {
+      return std::find(page.begin(), page.end(), FallbackTable::Unresolved) != page.end();
+    };
+    for (auto* face : bundledFaces) {
+      if (!has_gaps()) break;
+      if (face == primary) continue;
+      fillPageFromCmap(table, page, block, face);
+    }
     if (policy == FontFallbackPolicy::BundleOnly) {
-      fallbackCache[cacheKey] = primary;
-      return primary;
+      std::replace(page.begin(), page.end(), FallbackTable::Unresolved, uint16_t{0});
+    }
+    table.pages.push_back(page);
+    return static_cast<uint16_t>(table.pages.size());
+  }
+
+  FontFace* resolveOsFallbackFace(uint32_t codepoint) {
+    for (auto* face : osFaces) {
+      if (faceSupportsGlyph(face, codepoint)) return face;
+    }
+    if (syncFontIndex()) {
+      for (auto const& entry : fontIndex) {
+        if (!entry.covers(codepoint)) continue;
+        auto* face = openIndexedFace(entry);
+        if (face && faceSupportsGlyph(face, codepoint)) return face;
+      }
+      return nullptr;
     }
 
     while (true) {
       for (auto* face : osFaces) {
-        if (face_supports_glyph(face, codepoint)) {
-          fallbackCache[cacheKey] = face;
-          return face;
-        }
+        if (faceSupportsGlyph(face, codepoint)) return face;
       }
       if (!loadNextOsFallbackFace()) break;
     }
+    return nullptr;
+  }
 
-    fallbackCache[cacheKey] = primary;
-    return primary;
+  FontFace* resolveFaceForCodepoint(FallbackTable& table, uint32_t codepoint, FontFallbackPolicy policy) {
+    if (codepoint > 0x10FFFFu) return table.faces.front();
+    uint16_t& pageIndex = table.blockPages[codepoint >> 8];
+    if (pageIndex == 0) pageIndex = buildFallbackPage(table, codepoint >> 8, policy);
+    uint16_t& slot = table.pages[pageIndex - 1u][codepoint & 0xFFu];
+    if (slot == FallbackTable::Unresolved) {
+      FontFace* face = resolveOsFallbackFace(codepoint);
+      slot = face ? fallbackSlot(table, face) : 0u;
+    }
+    return table.faces[slot];
   }
 
   size_t resolveAtlasMax() {
@@ -673,89 +1568,99 @@ struct FontRegistry::Impl {
   GlyphBitmap* getGlyphBitmap(FontFace* face,
                               uint32_t glyphId,
                               uint16_t sizePx,
-                              uint16_t emboldenStrength) {
+                              uint16_t emboldenStrength,
+                              bool distanceField = false,
+                              uint8_t subpixelBin = 0) {
     if (!face || !face->face || sizePx == 0) return nullptr;
-    GlyphKey key{face->id, sizePx, emboldenStrength, glyphId};
+    if (distanceField) subpixelBin = 0;
+    GlyphKey key{face->id, sizePx, emboldenStrength, glyphId, distanceField, subpixelBin};
     auto it = glyphCache.find(key);
     if (it != glyphCache.end()) return it->second.get();
+    if (glyphRequests) {
+      glyphRequests->push_back(GlyphRequest{face, key});
+      return nullptr;
+    }
 
-    uint16_t effectiveSize = set_face_pixel_size(face->face, sizePx);
-    if (effectiveSize == 0) return nullptr;
-    FT_Int32 loadFlags = FT_LOAD_DEFAULT | FT_LOAD_COLOR;
-    if (FT_Load_Glyph(face->face, glyphId, loadFlags) != 0) return nullptr;
-    if (emboldenStrength > 0 && face->face->glyph->format == FT_GLYPH_FORMAT_OUTLINE) {
-      FT_Outline_Embolden(&face->face->glyph->outline, static_cast<FT_Pos>(emboldenStrength));
-    }
-    if (face->face->glyph->format != FT_GLYPH_FORMAT_BITMAP) {
-      if (FT_Render_Glyph(face->face->glyph, FT_RENDER_MODE_NORMAL) != 0) return nullptr;
-    }
-
-    FT_GlyphSlot slot = face->face->glyph;
-    FT_Bitmap& bm = slot->bitmap;
-
-    auto bitmap = std::make_unique<GlyphBitmap>();
-    bitmap->width = static_cast<int>(bm.width);
-    bitmap->height = static_cast<int>(bm.rows);
-    bitmap->bearingX = slot->bitmap_left;
-    bitmap->bearingY = slot->bitmap_top;
-    bitmap->advance = static_cast<int>(slot->advance.x / 64);
-    if (bm.buffer && bitmap->width > 0 && bitmap->height > 0) {
-      if (bm.pixel_mode == FT_PIXEL_MODE_BGRA) {
-        bitmap->format = GlyphBitmapFormat::ColorBGRA;
-        bitmap->stride = bitmap->width * 4;
-        bitmap->pixels.resize(static_cast<size_t>(bitmap->stride) * bitmap->height);
-        int pitch = bm.pitch;
-        for (int y = 0; y < bitmap->height; ++y) {
-          const uint8_t* srcRow = bm.buffer + (pitch >= 0 ? y * pitch : (bitmap->height - 1 - y) * -pitch);
-          uint8_t* dstRow = bitmap->pixels.data() + static_cast<size_t>(y) * bitmap->stride;
-          std::memcpy(dstRow, srcRow, static_cast<size_t>(bitmap->stride));
-        }
-      } else {
-        FontBitmapFormat format = FontBitmapFormat::Gray8;
-        switch (bm.pixel_mode) {
-          case FT_PIXEL_MODE_MONO: format = FontBitmapFormat::Mono1; break;
-          default: format = FontBitmapFormat::Gray8; break;
-        }
+    if (!activateSize(face, sizePx)) return nullptr;
+    auto bitmap = rasterize_glyph(face->face, key);
+    if (!bitmap) return nullptr;
+    return storeGlyph(key, std::move(bitmap));
+  }
 
-        FontBitmapView view;
-        view.buffer = bm.buffer;
-        view.width = bitmap->width;
-        view.height = bitmap->height;
-        view.pitch = bm.pitch;
-        view.format = format;
-
-        std::vector<uint8_t> converted;
-        int32_t convertedStride = 0;
-        if (!ConvertFontBitmapToAlpha(view, converted, convertedStride)) {
-          return nullptr;
+  GlyphBitmap* storeGlyph(GlyphKey const& key, std::unique_ptr<GlyphBitmap> bitmap) {
+    bitmap->identity = GlyphIdentity{serial, key.faceId, key.glyphId, key.sizePx, key.embolden,
+                                     key.subpixelBin, key.distanceField};
+    if (bitmap->format == GlyphBitmapFormat::Mask8 && !bitmap->pixels.empty()) {
+      int atlasX = 0;
+      int atlasY = 0;
+      if (auto atlas = allocateAtlasSlot(bitmap->width, bitmap->height, atlasX, atlasY)) {
+        for (int y = 0; y < bitmap->height; ++y) {
+          const uint8_t* srcRow = bitmap->pixels.data() + static_cast<size_t>(y) * bitmap->stride;
+          uint8_t* dstRow = atlas->pixels.data() +
+                            static_cast<size_t>(atlasY + y) * atlas->stride +
+                            static_cast<size_t>(atlasX);
+          std::memcpy(dstRow, srcRow, static_cast<size_t>(bitmap->width));
         }
+        bitmap->atlas = atlas;
+        bitmap->atlasX = atlasX;
+        bitmap->atlasY = atlasY;
+        bitmap->stride = atlas->stride;
+        bitmap->pixels = {};
+      }
+    }
+    auto [it, inserted] = glyphCache.try_emplace(key, std::move(bitmap));
+    return it->second.get();
+  }
 
-        bitmap->format = GlyphBitmapFormat::Mask8;
-        int atlasX = 0;
-        int atlasY = 0;
-        auto atlas = allocateAtlasSlot(bitmap->width, bitmap->height, atlasX, atlasY);
-        if (atlas) {
-          bitmap->atlas = atlas;
-          bitmap->atlasX = atlasX;
-          bitmap->atlasY = atlasY;
-          bitmap->stride = atlas->stride;
-          for (int y = 0; y < bitmap->height; ++y) {
-            const uint8_t* srcRow = converted.data() + static_cast<size_t>(y) * convertedStride;
-            uint8_t* dstRow = atlas->pixels.data() +
-                              static_cast<size_t>(atlasY + y) * atlas->stride +
-                              static_cast<size_t>(atlasX);
-            std::memcpy(dstRow, srcRow, static_cast<size_t>(bitmap->width));
+  // Runs layout for every sample x typography, recording the glyphs it would rasterize instead
+  // of rasterizing them. Subpixel typographies request every bin.
+  std::vector<GlyphRequest> collectGlyphRequests(std::span<std::string_view const> samples,
+                                                 std::span<Typography const> typographies,
+                                                 float deviceScale) {
+    std::vector<GlyphRequest> requests;
+    glyphRequests = &requests;
+    for (auto const& typography : typographies) {
+      size_t first = requests.size();
+      for (auto sample : samples) {
+        layoutText(sample, typography, deviceScale, /*buildGlyphs=*/true);
+      }
+      if (typography.subpixelPositioning) {
+        size_t last = requests.size();
+        for (size_t i = first; i < last; ++i) {
+          if (requests[i].key.distanceField) continue;
+          for (uint8_t bin = 0; bin < GlyphSubpixelBins; ++bin) {
+            GlyphRequest variant = requests[i];
+            variant.key.subpixelBin = bin;
+            requests.push_back(variant);
           }
-        } else {
-          bitmap->stride = bitmap->width;
-          bitmap->pixels = std::move(converted);
         }
       }
     }
+    glyphRequests = nullptr;
 
-    GlyphBitmap* out = bitmap.get();
-    glyphCache.emplace(key, std::move(bitmap));
-    return out;
+    auto order = [](GlyphKey const& key) {
+      return std::tuple(key.faceId, key.sizePx, key.embolden, key.distanceField, key.subpixelBin, key.glyphId);
+    };
+    std::sort(requests.begin(), requests.end(), [&](GlyphRequest const& a, GlyphRequest const& b) {
+      return order(a.key) < order(b.key);
+    });
+    requests.erase(std::unique(requests.begin(), requests.end(),
+                               [](GlyphRequest const& a, GlyphRequest const& b) { return a.key == b.key; }),
+                   requests.end());
+    std::erase_if(requests, [&](GlyphRequest const& request) { return glyphCache.contains(request.key); });
+    return requests;
+  }
+
+  // Expects the face to be sized to sizePx already (as during shaping).
+  GlyphMetrics const& getGlyphMetrics(FontFace* face, uint32_t glyphId, uint16_t sizePx) {
+    GlyphKey key{face->id, sizePx, 0, glyphId};
+    auto [it, inserted] = glyphMetricsCache.try_emplace(key);
+    if (inserted && FT_Load_Glyph(face->face, glyphId, FT_LOAD_DEFAULT) == 0) {
+      it->second.bearingX = face->face->glyph->metrics.horiBearingX;
+      it->second.width = face->face->glyph->metrics.width;
+      it->second.valid = true;
+    }
+    return it->second;
   }
 
   std::shared_ptr<TextRun> layoutText(std::string_view text,
@@ -776,7 +1681,8 @@ struct FontRegistry::Impl {
     float invScale = 1.0f / scale;
     uint16_t sizePixels = static_cast<uint16_t>(std::max(1.0f, std::round(typography.size * scale)));
 
-    auto codepoints = decode_utf8(text);
+    auto& codepoints = codepointScratch;
+    decode_utf8(text, codepoints);
     if (codepoints.empty()) return nullptr;
 
     struct RunSegment {
@@ -788,10 +1694,11 @@ struct FontRegistry::Impl {
     std::vector<RunSegment> segments;
     segments.reserve(codepoints.size());
 
+    FallbackTable& fallback = fallbackTableFor(primary, typography.fallback);
     FontFace* currentFace = nullptr;
     size_t segmentStart = 0;
     for (size_t i = 0; i < codepoints.size(); ++i) {
-      FontFace* face = resolveFaceForCodepoint(codepoints[i].codepoint, primary, typography.fallback);
+      FontFace* face = resolveFaceForCodepoint(fallback, codepoints[i].codepoint, typography.fallback);
       if (!currentFace) {
         currentFace = face;
         segmentStart = i;
@@ -805,9 +1712,28 @@ struct FontRegistry::Impl {
     }
     segments.push_back(RunSegment{currentFace, segmentStart, codepoints.size()});
 
+    bool distanceField = typography.distanceField && buildGlyphs;
+    for (auto const& seg : segments) {
+      if (seg.face && seg.face->face && !FT_IS_SCALABLE(seg.face->face)) {
+        distanceField = false;
+      }
+    }
+
     auto run = std::make_shared<TextRun>();
     run->layoutScale = scale;
-    run->contentHash = 1469598103934665603ull;
+    // Face ids restart per registry, so runs from different registries must never hash alike.
+    run->contentHash = fnv1a_hash(1469598103934665603ull, serial);
+    run->contentHash = fnv1a_hash(run->contentHash, buildGlyphs ? 1u : 0u);
+    if (distanceField) {
+      run->glyphScale = static_cast<float>(sizePixels) / static_cast<float>(GlyphSdfReferenceSize);
+      run->contentHash = fnv1a_hash(run->contentHash, static_cast<uint64_t>(GlyphSdfReferenceSize));
+    }
+    bool subpixel = typography.subpixelPositioning && !distanceField;
+    // Bitmap variants depend on these as well as on glyph ids and positions.
+    run->contentHash = fnv1a_hash(run->contentHash, static_cast<uint64_t>(sizePixels));
+    run->contentHash = fnv1a_hash(run->contentHash, (distanceField ? 1u : 0u) | (subpixel ? 2u : 0u));
+    float bitmapScale = run->glyphScale * invScale;
+    int32_t bitmapPadding = distanceField ? GlyphSdfSpread : 0;
 
     float penX = 0.0f;
     float penY = 0.0f;
@@ -821,15 +1747,16 @@ struct FontRegistry::Impl {
     for (auto const& seg : segments) {
       if (!seg.face || !seg.face->face || seg.startIndex >= seg.endIndex) continue;
 
-      uint16_t effectiveSize = set_face_pixel_size(seg.face->face, sizePixels);
-      if (effectiveSize == 0) {
+      SizedFace* sized = activateSize(seg.face, sizePixels);
+      if (!sized || !sized->hbFont) {
         continue;
       }
-      if (seg.face->hbFont) {
-        hb_ft_font_set_load_flags(seg.face->hbFont, FT_LOAD_DEFAULT);
-        hb_ft_font_changed(seg.face->hbFont);
-      }
+      uint16_t effectiveSize = sized->effectiveSize;
       uint16_t emboldenStrength = compute_synthetic_bold(seg.face->weight, typography.weight, effectiveSize);
+      uint16_t bitmapSize = distanceField ? GlyphSdfReferenceSize : effectiveSize;
+      uint16_t bitmapEmbolden = distanceField
+                                  ? compute_synthetic_bold(seg.face->weight, typography.weight, bitmapSize)
+                                  : emboldenStrength;
       if (emboldenStrength > 0) {
         float emboldenLogical = static_cast<float>(emboldenStrength) / 64.0f * invScale;
         maxEmbolden = std::max(maxEmbolden, emboldenLogical);
@@ -838,25 +1765,36 @@ struct FontRegistry::Impl {
       size_t startByte = codepoints[seg.startIndex].byteOffset;
       size_t endByte = codepoints[seg.endIndex - 1].byteOffset + codepoints[seg.endIndex - 1].byteLength;
 
-      hb_buffer_t* buffer = hb_buffer_create();
-      hb_buffer_add_utf8(buffer,
-                         text.data() + startByte,
-                         static_cast<int>(endByte - startByte),
-                         0,
-                         static_cast<int>(endByte - startByte));
-      if (!typography.locale.empty()) {
-        hb_buffer_set_language(buffer, hb_language_from_string(typography.locale.c_str(), -1));
-      }
-      hb_buffer_guess_segment_properties(buffer);
+      unsigned int glyphCount = 0;
+      hb_glyph_info_t* infos = nullptr;
+      hb_glyph_position_t* positions = nullptr;
+      if (latinFastPath && features.empty() && typography.locale.empty() &&
+          shapeAscii(*sized, text.substr(startByte, endByte - startByte))) {
+        glyphCount = static_cast<unsigned int>(asciiInfos.size());
+        infos = asciiInfos.data();
+        positions = asciiPositions.data();
+      } else {
+        if (!shapeBuffer) shapeBuffer = hb_buffer_create();
+        hb_buffer_t* buffer = shapeBuffer;
+        hb_buffer_clear_contents(buffer);
+        hb_buffer_add_utf8(buffer,
+                           text.data() + startByte,
+                           static_cast<int>(endByte - startByte),
+                           0,
+                           static_cast<int>(endByte - startByte));
+        if (!typography.locale.empty()) {
+          hb_buffer_set_language(buffer, hb_language_from_string(typography.locale.c_str(), -1));
+        }
+        hb_buffer_guess_segment_properties(buffer);
 
-      hb_shape(seg.face->hbFont,
-               buffer,
-               features.empty() ? nullptr : features.data(),
-               static_cast<unsigned int>(features.size()));
+        hb_shape(sized->hbFont,
+                 buffer,
+                 features.empty() ? nullptr : features.data(),
+                 static_cast<unsigned int>(features.size()));
 
-      unsigned int glyphCount = 0;
-      hb_glyph_info_t* infos = hb_buffer_get_glyph_infos(buffer, &glyphCount);
-      hb_glyph_position_t* positions = hb_buffer_get_glyph_positions(buffer, &glyphCount);
+        infos = hb_buffer_get_glyph_infos(buffer, &glyphCount);
+        positions = hb_buffer_get_glyph_positions(buffer, &glyphCount);
+      }
       auto codepoint_for_cluster = [&](unsigned int cluster) -> std::optional<uint32_t> {
         size_t absolute = startByte + static_cast<size_t>(cluster);
         auto begin = codepoints.begin() + static_cast<long>(seg.startIndex);
@@ -890,7 +1828,13 @@ struct FontRegistry::Impl {
         }
         placement.cluster = static_cast<uint32_t>(absolute);
         if (buildGlyphs) {
-          placement.bitmap = getGlyphBitmap(seg.face, infos[i].codepoint, effectiveSize, emboldenStrength);
+          uint8_t subpixelBin = 0;
+          if (subpixel) {
+            long quarter = std::lround(placement.x * scale * static_cast<float>(GlyphSubpixelBins));
+            subpixelBin = static_cast<uint8_t>(((quarter % GlyphSubpixelBins) + GlyphSubpixelBins) % GlyphSubpixelBins);
+          }
+          placement.bitmap =
+            getGlyphBitmap(seg.face, infos[i].codepoint, bitmapSize, bitmapEmbolden, distanceField, subpixelBin);
         }
         run->glyphs.push_back(placement);
 
@@ -898,12 +1842,13 @@ struct FontRegistry::Impl {
         if (buildGlyphs && placement.bitmap) {
           glyphRight = std::max(glyphRight,
                                 placement.x + (static_cast<float>(placement.bitmap->bearingX +
-                                                                  placement.bitmap->width) * invScale));
+                                                                  placement.bitmap->width - bitmapPadding) *
+                                               bitmapScale));
         } else if (!buildGlyphs) {
-          if (FT_Load_Glyph(seg.face->face, infos[i].codepoint, FT_LOAD_DEFAULT) == 0) {
-            FT_GlyphSlot slot = seg.face->face->glyph;
-            float bearingX = static_cast<float>(slot->metrics.horiBearingX) / 64.0f;
-            float glyphWidth = static_cast<float>(slot->metrics.width) / 64.0f;
+          GlyphMetrics const& glyphMetrics = getGlyphMetrics(seg.face, infos[i].codepoint, effectiveSize);
+          if (glyphMetrics.valid) {
+            float bearingX = static_cast<float>(glyphMetrics.bearingX) / 64.0f;
+            float glyphWidth = static_cast<float>(glyphMetrics.width) / 64.0f;
             float right = placement.x + (bearingX + glyphWidth) * invScale;
             if (emboldenStrength > 0) {
               right += static_cast<float>(emboldenStrength) / 64.0f * invScale;
@@ -947,7 +1892,6 @@ struct FontRegistry::Impl {
         run->contentHash = fnv1a_hash(run->contentHash, static_cast<uint64_t>(std::lround(placement.y * 64.0f)));
       }
 
-      hb_buffer_destroy(buffer);
     }
 
     run->baseline = maxAscender;
@@ -973,6 +1917,16 @@ struct FontRegistry::Impl {
     int h = static_cast<int>(std::ceil(run->height));
     return {w, h};
   }
+
+  std::vector<std::pair<int, int>> measureTexts(std::span<std::string_view const> texts,
+                                                Typography const& typography) {
+    std::vector<std::pair<int, int>> out;
+    out.reserve(texts.size());
+    for (auto text : texts) {
+      out.push_back(measureText(text, typography));
+    }
+    return out;
+  }
 };
 
 FontRegistry::FontRegistry()
@@ -1004,6 +1958,69 @@ void FontRegistry::loadOsFallbackFonts() {
   impl->loadOsFallbackFonts();
 }
 
+void FontRegistry::setOsFontIndexPath(std::string path) {
+  if (!impl) return;
+  std::lock_guard<std::mutex> lock(impl->mutex);
+  impl->fontIndexPath = std::move(path);
+  impl->fontIndexLoaded = false;
+  impl->fontIndexRefreshed = false;
+}
+
+void FontRegistry::setLatinFastPathEnabled(bool enabled) {
+  if (!impl) return;
+  std::lock_guard<std::mutex> lock(impl->mutex);
+  impl->latinFastPath = enabled;
+}
+
+void FontRegistry::prewarmGlyphs(std::span<std::string_view const> samples,
+                                 std::span<Typography const> typographies,
+                                 float deviceScale) {
+  if (!impl) return;
+  std::vector<GlyphRequest> requests;
+  {
+    std::lock_guard<std::mutex> lock(impl->mutex);
+    requests = impl->collectGlyphRequests(samples, typographies, deviceScale);
+  }
+  auto bitmaps = rasterize_glyphs_parallel(requests);
+  std::lock_guard<std::mutex> lock(impl->mutex);
+  for (size_t i = 0; i < requests.size(); ++i) {
+    if (bitmaps[i]) impl->storeGlyph(requests[i].key, std::move(bitmaps[i]));
+  }
+}
+
+void FontRegistry::buildOsFontIndex() {
+  if (!impl) return;
+  std::lock_guard<std::mutex> lock(impl->mutex);
+  impl->syncFontIndex();
+}
+
+auto FontRegistry::waitForOsFontIndex() -> size_t {
+  if (!impl) return 0;
+  std::unique_lock<std::mutex> lock(impl->mutex);
+  return impl->waitForFontIndex(lock);
+}
+
+void FontRegistry::setFontFileMappingEnabled(bool enabled) {
+  if (!impl) return;
+  std::lock_guard<std::mutex> lock(impl->mutex);
+  impl->mapFontFiles = enabled;
+}
+
+auto FontRegistry::faceStats() const -> FontFaceStats {
+  FontFaceStats stats;
+  if (!impl) return stats;
+  std::lock_guard<std::mutex> lock(impl->mutex);
+  std::unordered_set<MappedFile const*> files;
+  for (auto const& face : impl->faces) {
+    ++stats.registered;
+    if (face->face) ++stats.opened;
+    MappedFile const* file = face->source.file.get();
+    if (!file || !files.insert(file).second) continue;
+    ++(file->mapping ? stats.mappedFiles : stats.readFiles);
+  }
+  return stats;
+}
+
 bool FontRegistry::hasBundledFaces() const {
   return impl && !impl->bundledFaces.empty();
 }
@@ -1017,6 +2034,15 @@ auto FontRegistry::layoutText(std::string_view text,
   return impl->layoutText(text, typography, deviceScale, buildGlyphs);
 }
 
+auto FontRegistry::layoutParagraph(std::string_view text,
+                                   Typography const& typography,
+                                   float deviceScale,
+                                   bool buildGlyphs) -> std::shared_ptr<ParagraphLayout> {
+  auto run = layoutText(text, typography, deviceScale, buildGlyphs);
+  if (!run) return nullptr;
+  return std::make_shared<ParagraphLayout>(BuildParagraphLayout(text, std::move(run)));
+}
+
 auto FontRegistry::measureText(std::string_view text,
                                Typography const& typography) -> std::pair<int, int> {
   if (!impl) return {0, 0};
@@ -1024,6 +2050,13 @@ auto FontRegistry::measureText(std::string_view text,
   return impl->measureText(text, typography);
 }
 
+auto FontRegistry::measureTexts(std::span<std::string_view const> texts,
+                                Typography const& typography) -> std::vector<std::pair<int, int>> {
+  if (!impl) return std::vector<std::pair<int, int>>(texts.size(), std::pair<int, int>{0, 0});
+  std::lock_guard<std::mutex> lock(impl->mutex);
+  return impl->measureTexts(texts, typography);
+}
+
 FontRegistry& GetFontRegistry() {
   static FontRegistry registry;
   return registry;
@@ -1036,9 +2069,21 @@ auto LayoutText(std::string_view text,
   return GetFontRegistry().layoutText(text, typography, deviceScale, buildGlyphs);
 }
 
+auto LayoutParagraph(std::string_view text,
+                     Typography const& typography,
+                     float deviceScale,
+                     bool buildGlyphs) -> std::shared_ptr<ParagraphLayout> {
+  return GetFontRegistry().layoutParagraph(text, typography, deviceScale, buildGlyphs);
+}
+
 auto MeasureText(std::string_view text,
                  Typography const& typography) -> std::pair<int, int> {
   return GetFontRegistry().measureText(text, typography);
 }
 
+auto MeasureTexts(std::span<std::string_view const> texts,
+                  Typography const& typography) -> std::vector<std::pair<int, int>> {
+  return GetFontRegistry().measureTexts(texts, typography);
+}
+
 } // namespace PrimeManifest
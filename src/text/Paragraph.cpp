@@ -0,0 +1,287 @@
+#include "PrimeManifest/text/Paragraph.hpp"
+
+#include <algorithm>
+
+namespace PrimeManifest {
+
+namespace {
+
+enum class BreakClass : uint8_t {
+  Other,
+  Space,
+  Mandatory,
+  CarriageReturn,
+  LineFeed,
+  ZeroWidthSpace,
+  Glue,
+  Hyphen,
+  Open,
+  Close,
+  Numeric,
+  Ideographic,
+};
+
+auto next_codepoint(std::string_view text, size_t& i) -> uint32_t {
+  unsigned char c = static_cast<unsigned char>(text[i]);
+  auto cont = [&](size_t k) -> uint32_t { return static_cast<unsigned char>(text[i + k]) & 0x3Fu; };
+  uint32_t cp = 0xFFFDu;
+  if (c < 0x80) {
+    cp = c;
+    i += 1;
+  } else if ((c >> 5) == 0x6 && i + 1 < text.size()) {
+    cp = ((c & 0x1Fu) << 6) | cont(1);
+    i += 2;
+  } else if ((c >> 4) == 0xE && i + 2 < text.size()) {
+    cp = ((c & 0x0Fu) << 12) | (cont(1) << 6) | cont(2);
+    i += 3;
+  } else if ((c >> 3) == 0x1E && i + 3 < text.size()) {
+    cp = ((c & 0x07u) << 18) | (cont(1) << 12) | (cont(2) << 6) | cont(3);
+    i += 4;
+  } else {
+    i += 1;
+  }
+  return cp;
+}
+
+auto classify(uint32_t cp) -> BreakClass {
+  switch (cp) {
+    case 0x0Au: return BreakClass::LineFeed;
+    case 0x0Du: return BreakClass::CarriageReturn;
+    case 0x0Bu:
+    case 0x0Cu:
+    case 0x85u:
+    case 0x2028u:
+    case 0x2029u:
+      return BreakClass::Mandatory;
+    case 0x09u:
+    case 0x20u:
+    case 0x1680u:
+    case 0x205Fu:
+    case 0x3000u:
+      return BreakClass::Space;
+    case 0x200Bu: return BreakClass::ZeroWidthSpace;
+    case 0xA0u:
+    case 0x2007u:
+    case 0x2011u:
+    case 0x202Fu:
+    case 0x2060u:
+    case 0xFEFFu:
+      return BreakClass::Glue;
+    case '-':
+    case 0xADu:
+    case 0x2010u:
+    case 0x2012u:
+    case 0x2013u:
+      return BreakClass::Hyphen;
+    case '(':
+    case '[':
+    case '{':
+    case 0x3008u:
+    case 0x300Au:
+    case 0x300Cu:
+    case 0x300Eu:
+    case 0x3010u:
+    case 0xFF08u:
+      return BreakClass::Open;
+    case ')':
+    case ']':
+    case '}':
+    case '!':
+    case '?':
+    case ',':
+    case '.':
+    case ':':
+    case ';':
+    case '/':
+    case 0x3001u:
+    case 0x3002u:
+    case 0x3009u:
+    case 0x300Bu:
+    case 0x300Du:
+    case 0x300Fu:
+    case 0x3011u:
+    case 0xFF01u:
+    case 0xFF09u:
+    case 0xFF0Cu:
+    case 0xFF0Eu:
+    case 0xFF1Au:
+    case 0xFF1Bu:
+    case 0xFF1Fu:
+      return BreakClass::Close;
+    default:
+      break;
+  }
+  if (cp >= '0' && cp <= '9') return BreakClass::Numeric;
+  if ((cp >= 0x2000u && cp <= 0x2006u) || (cp >= 0x2008u && cp <= 0x200Au)) return BreakClass::Space;
+  if ((cp >= 0x2E80u && cp <= 0x2FFFu) ||
+      (cp >= 0x3040u && cp <= 0x30FFu) ||
+      (cp >= 0x3400u && cp <= 0x4DBFu) ||
+      (cp >= 0x4E00u && cp <= 0x9FFFu) ||
+      (cp >= 0xAC00u && cp <= 0xD7A3u) ||
+      (cp >= 0xF900u && cp <= 0xFAFFu) ||
+      (cp >= 0xFF00u && cp <= 0xFF60u) ||
+      (cp >= 0x1F300u && cp <= 0x1FAFFu) ||
+      (cp >= 0x20000u && cp <= 0x3FFFDu)) {
+    return BreakClass::Ideographic;
+  }
+  return BreakClass::Other;
+}
+
+auto is_line_end(BreakClass cls) -> bool {
+  return cls == BreakClass::Mandatory || cls == BreakClass::LineFeed || cls == BreakClass::CarriageReturn;
+}
+
+} // namespace
+
+auto FindLineBreaks(std::string_view text) -> std::vector<TextLineBreak> {
+  std::vector<TextLineBreak> out;
+  size_t i = 0;
+  bool hasPrev = false;
+  BreakClass prev = BreakClass::Other;
+  BreakClass base = BreakClass::Other;
+  bool spacesAfterBase = false;
+  while (i < text.size()) {
+    size_t offset = i;
+    BreakClass cls = classify(next_codepoint(text, i));
+    if (hasPrev) {
+      bool breakHere = false;
+      bool mandatory = false;
+      if (prev == BreakClass::CarriageReturn && cls == BreakClass::LineFeed) {
+        breakHere = false;
+      } else if (is_line_end(prev)) {
+        breakHere = true;
+        mandatory = true;
+      } else if (cls == BreakClass::Space || is_line_end(cls)) {
+        breakHere = false;
+      } else if (base == BreakClass::ZeroWidthSpace) {
+        breakHere = true;
+      } else if (cls == BreakClass::Glue || (base == BreakClass::Glue && !spacesAfterBase)) {
+        breakHere = false;
+      } else if (cls == BreakClass::Close || cls == BreakClass::ZeroWidthSpace || base == BreakClass::Open) {
+        breakHere = false;
+      } else if (spacesAfterBase) {
+        breakHere = true;
+      } else if (base == BreakClass::Hyphen) {
+        breakHere = cls != BreakClass::Numeric;
+      } else if (base == BreakClass::Ideographic || cls == BreakClass::Ideographic) {
+        breakHere = true;
+      }
+      if (breakHere) {
+        out.push_back(TextLineBreak{static_cast<uint32_t>(offset), mandatory});
+      }
+    }
+    hasPrev = true;
+    prev = cls;
+    if (cls == BreakClass::Space) {
+      spacesAfterBase = true;
+    } else {
+      base = cls;
+      spacesAfterBase = false;
+    }
+  }
+  return out;
+}
+
+auto BuildParagraphLayout(std::string_view text, std::shared_ptr<TextRun> run) -> ParagraphLayout {
+  ParagraphLayout paragraph;
+  paragraph.breaks = FindLineBreaks(text);
+  paragraph.run = std::move(run);
+  if (!paragraph.run) return paragraph;
+
+  auto const& glyphs = paragraph.run->glyphs;
+  paragraph.glyphFlags.assign(glyphs.size(), 0u);
+  size_t nextBreak = 0;
+  for (size_t gi = 0; gi < glyphs.size(); ++gi) {
+    uint32_t cluster = glyphs[gi].cluster;
+    if (gi > 0 && cluster != glyphs[gi - 1].cluster) {
+      while (nextBreak < paragraph.breaks.size() && paragraph.breaks[nextBreak].byteOffset < cluster) {
+        ++nextBreak;
+      }
+      if (nextBreak < paragraph.breaks.size() && paragraph.breaks[nextBreak].byteOffset == cluster) {
+        paragraph.glyphFlags[gi] |= paragraph.breaks[nextBreak].mandatory ? ParagraphGlyphBreakMandatory
+                                                                          : ParagraphGlyphBreakAllowed;
+      }
+    }
+    if (cluster < text.size()) {
+      size_t cursor = cluster;
+      BreakClass cls = classify(next_codepoint(text, cursor));
+      if (cls == BreakClass::Space || cls == BreakClass::ZeroWidthSpace) {
+        paragraph.glyphFlags[gi] |= ParagraphGlyphSpace;
+      } else if (is_line_end(cls)) {
+        paragraph.glyphFlags[gi] |= ParagraphGlyphNewline;
+      }
+    }
+  }
+  return paragraph;
+}
+
+auto WrapParagraph(ParagraphLayout const& paragraph, float maxWidth) -> std::vector<TextRun> {
+  std::vector<TextRun> lines;
+  if (!paragraph.run) return lines;
+  TextRun const& run = *paragraph.run;
+  auto const& glyphs = run.glyphs;
+  size_t count = glyphs.size();
+  bool flagsValid = paragraph.glyphFlags.size() == count;
+  auto flags_at = [&](size_t gi) -> uint8_t { return flagsValid ? paragraph.glyphFlags[gi] : 0u; };
+
+  auto emit_line = [&](size_t start, size_t end, float width) {
+    TextRun line;
+    line.height = run.height;
+    line.baseline = run.baseline;
+    line.layoutScale = run.layoutScale;
+    line.glyphScale = run.glyphScale;
+    line.width = width;
+    line.contentHash = run.contentHash;
+    line.contentHash = (line.contentHash ^ static_cast<uint64_t>(start)) * 1099511628211ull;
+    line.contentHash = (line.contentHash ^ static_cast<uint64_t>(end)) * 1099511628211ull;
+    float originX = start < count ? glyphs[start].x : 0.0f;
+    line.glyphs.reserve(end - start);
+    for (size_t gi = start; gi < end; ++gi) {
+      if ((flags_at(gi) & ParagraphGlyphNewline) != 0u) continue;
+      GlyphPlacement placement = glyphs[gi];
+      placement.x -= originX;
+      line.glyphs.push_back(placement);
+    }
+    lines.push_back(std::move(line));
+  };
+
+  size_t start = 0;
+  while (start < count) {
+    float originX = glyphs[start].x;
+    size_t lastBreak = start;
+    size_t end = count;
+    float width = 0.0f;
+    float widthAtBreak = 0.0f;
+    for (size_t gi = start; gi < count; ++gi) {
+      uint8_t flags = flags_at(gi);
+      if (gi > start && (flags & ParagraphGlyphBreakMandatory) != 0u) {
+        end = gi;
+        break;
+      }
+      if (gi > start && (flags & ParagraphGlyphBreakAllowed) != 0u) {
+        lastBreak = gi;
+        widthAtBreak = width;
+      }
+      if ((flags & (ParagraphGlyphSpace | ParagraphGlyphNewline)) != 0u) continue;
+      float right = glyphs[gi].x + glyphs[gi].advance - originX;
+      if (maxWidth > 0.0f && right > maxWidth && gi > start) {
+        if (lastBreak > start) {
+          end = lastBreak;
+          width = widthAtBreak;
+        } else {
+          end = gi;
+        }
+        break;
+      }
+      width = std::max(width, right);
+    }
+    emit_line(start, end, width);
+    start = end;
+  }
+  if (lines.empty() || (count > 0 && (flags_at(count - 1) & ParagraphGlyphNewline) != 0u)) {
+    emit_line(count, count, 0.0f);
+  }
+  return lines;
+}
+
+} // namespace PrimeManifest
@@ -5,6 +5,7 @@
 #include <cstring>
 #include <limits>
 #include <unordered_map>
+#include <vector>
 
 namespace PrimeManifest {
 
@@ -22,6 +23,7 @@ auto copy_bitmap(GlyphBitmap const& src) -> GlyphStore::GlyphBitmap {
   out.bearingY = src.bearingY;
   out.advance = src.advance;
   out.format = src.format;
+  out.subpixelBin = src.subpixelBin;
   out.atlasIndex = -1;
   out.atlasX = 0;
   out.atlasY = 0;
@@ -64,8 +66,88 @@ auto bitmap_is_opaque(GlyphStore::GlyphBitmap const& bmp) -> bool {
   return false;
 }
 
+auto bake_key(uint64_t contentHash, int16_t baselineQ8_8, uint16_t scaleQ8_8, uint16_t glyphScaleQ8_8) -> uint64_t {
+  constexpr uint64_t Prime = 1099511628211ull;
+  uint64_t h = contentHash;
+  h = (h ^ static_cast<uint16_t>(baselineQ8_8)) * Prime;
+  h = (h ^ scaleQ8_8) * Prime;
+  h = (h ^ glyphScaleQ8_8) * Prime;
+  return h;
+}
+
+// A run baked on an earlier frame is reusable while its glyph placements have not been dropped.
+auto run_is_baked(RenderBatch const& batch, TextRunStore::BakedRun const& baked) -> bool {
+  if (baked.placementGeneration != batch.glyphs.placementGeneration) return false;
+  uint32_t runIndex = baked.runIndex;
+  if (runIndex >= batch.runs.glyphStart.size() || runIndex >= batch.runs.glyphCount.size()) return false;
+  uint64_t end = static_cast<uint64_t>(batch.runs.glyphStart[runIndex]) + batch.runs.glyphCount[runIndex];
+  return end <= batch.glyphs.glyphXQ8_8.size();
+}
+
+auto has_mask_spans(GlyphStore::GlyphBitmap const& bmp) -> bool {
+  return bmp.height > 0 && bmp.maskSpanRows.size() == static_cast<size_t>(bmp.height) + 1u;
+}
+
+void decode_mask_span_row(GlyphStore::GlyphBitmap const& bmp, int32_t row, std::vector<uint8_t>& out) {
+  out.assign(static_cast<size_t>(bmp.width), 0u);
+  size_t i = bmp.maskSpanRows[static_cast<size_t>(row)];
+  size_t end = std::min<size_t>(bmp.maskSpanRows[static_cast<size_t>(row) + 1u], bmp.maskSpans.size());
+  int32_t x = 0;
+  while (i < end && x < bmp.width) {
+    uint8_t token = bmp.maskSpans[i++];
+    int32_t len = std::min<int32_t>((token & 0x3Fu) + 1, bmp.width - x);
+    uint8_t kind = static_cast<uint8_t>(token >> 6);
+    if (kind == GlyphSpanSolid) {
+      std::fill_n(out.data() + x, len, uint8_t{255});
+    } else if (kind == GlyphSpanBlend) {
+      size_t count = std::min<size_t>(static_cast<size_t>(len), end - i);
+      std::memcpy(out.data() + x, bmp.maskSpans.data() + i, count);
+      i += static_cast<size_t>((token & 0x3Fu) + 1);
+    }
+    x += len;
+  }
+}
+
 } // namespace
 
+auto EncodeGlyphMaskSpans(GlyphStore::GlyphBitmap& bitmap) -> bool {
+  if (bitmap.format != GlyphBitmapFormat::Mask8 || bitmap.atlasIndex >= 0) return false;
+  if (bitmap.width <= 0 || bitmap.height <= 0 || bitmap.stride < bitmap.width) return false;
+  if (bitmap.pixels.size() < static_cast<size_t>(bitmap.stride) * static_cast<size_t>(bitmap.height)) return false;
+
+  auto kind_of = [](uint8_t cov) -> uint8_t {
+    if (cov == 0u) return GlyphSpanSkip;
+    return cov == 255u ? GlyphSpanSolid : GlyphSpanBlend;
+  };
+  std::vector<uint8_t> spans;
+  std::vector<uint32_t> rows;
+  rows.reserve(static_cast<size_t>(bitmap.height) + 1u);
+  for (int32_t y = 0; y < bitmap.height; ++y) {
+    rows.push_back(static_cast<uint32_t>(spans.size()));
+    uint8_t const* src = bitmap.pixels.data() + static_cast<size_t>(y) * bitmap.stride;
+    int32_t last = bitmap.width;
+    while (last > 0 && src[last - 1] == 0u) --last;
+    int32_t x = 0;
+    while (x < last) {
+      uint8_t kind = kind_of(src[x]);
+      int32_t len = 1;
+      while (x + len < last && len < GlyphSpanMaxLength && kind_of(src[x + len]) == kind) ++len;
+      spans.push_back(static_cast<uint8_t>((kind << 6) | (len - 1)));
+      if (kind == GlyphSpanBlend) {
+        spans.insert(spans.end(), src + x, src + x + len);
+      }
+      x += len;
+    }
+  }
+  rows.push_back(static_cast<uint32_t>(spans.size()));
+
+  bitmap.maskSpans = std::move(spans);
+  bitmap.maskSpanRows = std::move(rows);
+  bitmap.pixels.clear();
+  bitmap.pixels.shrink_to_fit();
+  return true;
+}
+
 auto AppendTextRun(RenderBatch& batch,
                    TextRun const& run,
                    int32_t x,
@@ -73,39 +155,89 @@ auto AppendTextRun(RenderBatch& batch,
                    uint8_t colorIndex,
                    uint8_t opacity,
                    uint8_t flags) -> std::optional<TextBakeResult> {
-  uint32_t glyphStart = static_cast<uint32_t>(batch.glyphs.glyphXQ8_8.size());
-  std::unordered_map<GlyphBitmap const*, uint32_t> bitmapCache;
-  bitmapCache.reserve(run.glyphs.size());
-
-  for (auto const& glyph : run.glyphs) {
-    if (!glyph.bitmap) continue;
-    if (glyph.bitmap->width <= 0 || glyph.bitmap->height <= 0) continue;
-    uint32_t bitmapIndex = 0;
-    auto it = bitmapCache.find(glyph.bitmap);
-    if (it != bitmapCache.end()) {
-      bitmapIndex = it->second;
-    } else {
-      GlyphStore::GlyphBitmap copied = copy_bitmap(*glyph.bitmap);
-      bitmapIndex = static_cast<uint32_t>(batch.glyphs.bitmaps.size());
-      batch.glyphs.bitmaps.push_back(std::move(copied));
-      batch.glyphs.bitmapOpaque.push_back(bitmap_is_opaque(batch.glyphs.bitmaps.back()) ? 1u : 0u);
-      bitmapCache.emplace(glyph.bitmap, bitmapIndex);
+  int16_t baselineQ8_8 = static_cast<int16_t>(std::lround(run.baseline * 256.0f));
+  float scale = run.layoutScale > 0.0f ? run.layoutScale : 1.0f;
+  uint16_t scaleQ8_8 = clamp_u16(static_cast<uint32_t>(std::lround(scale * 256.0f)));
+  float glyphScale = run.glyphScale > 0.0f ? run.glyphScale : 1.0f;
+  uint16_t glyphScaleQ8_8 = clamp_u16(static_cast<uint32_t>(std::lround(glyphScale * 256.0f)));
+
+  uint64_t bakeKey = 0;
+  std::optional<uint32_t> bakedRun;
+  if (run.contentHash != 0) {
+    bakeKey = bake_key(run.contentHash, baselineQ8_8, scaleQ8_8, glyphScaleQ8_8);
+    auto it = batch.runs.bakedLookup.find(bakeKey);
+    if (it != batch.runs.bakedLookup.end() && run_is_baked(batch, it->second)) {
+      bakedRun = it->second.runIndex;
+    }
+  }
+
+  uint32_t runIndex = 0;
+  if (bakedRun) {
+    runIndex = *bakedRun;
+  } else {
+    uint32_t glyphStart = static_cast<uint32_t>(batch.glyphs.glyphXQ8_8.size());
+    auto& bitmapLookup = batch.glyphs.bitmapLookup;
+    // Caller-owned bitmaps are only known to be alive for this call, so their addresses are
+    // never kept in the store.
+    std::unordered_map<void const*, uint32_t> localLookup;
+
+    for (auto const& glyph : run.glyphs) {
+      if (!glyph.bitmap) continue;
+      if (glyph.bitmap->width <= 0 || glyph.bitmap->height <= 0) continue;
+      uint32_t bitmapIndex = 0;
+      GlyphIdentity const& identity = glyph.bitmap->identity;
+      std::optional<uint32_t> cached;
+      if (identity.registry != 0) {
+        if (auto it = bitmapLookup.find(identity); it != bitmapLookup.end()) cached = it->second;
+      } else if (auto it = localLookup.find(glyph.bitmap); it != localLookup.end()) {
+        cached = it->second;
+      }
+      if (cached && *cached < batch.glyphs.bitmaps.size() && *cached < batch.glyphs.bitmapOpaque.size()) {
+        bitmapIndex = *cached;
+      } else {
+        GlyphStore::GlyphBitmap copied = copy_bitmap(*glyph.bitmap);
+        bitmapIndex = static_cast<uint32_t>(batch.glyphs.bitmaps.size());
+        batch.glyphs.bitmaps.push_back(std::move(copied));
+        batch.glyphs.bitmapOpaque.resize(batch.glyphs.bitmaps.size(), 0u);
+        batch.glyphs.bitmapOpaque[bitmapIndex] = bitmap_is_opaque(batch.glyphs.bitmaps.back()) ? 1u : 0u;
+        if (batch.glyphs.encodeMaskSpans) {
+          EncodeGlyphMaskSpans(batch.glyphs.bitmaps.back());
+        }
+        if (identity.registry != 0) {
+          bitmapLookup.insert_or_assign(identity, bitmapIndex);
+        } else {
+          localLookup.insert_or_assign(glyph.bitmap, bitmapIndex);
+        }
+      }
+
+      int32_t gx = static_cast<int32_t>(std::lround(glyph.x * 256.0f));
+      int32_t gy = static_cast<int32_t>(std::lround(glyph.y * 256.0f));
+      batch.glyphs.glyphXQ8_8.push_back(gx);
+      batch.glyphs.glyphYQ8_8.push_back(gy);
+      batch.glyphs.bitmapIndex.push_back(bitmapIndex);
     }
 
-    int32_t gx = static_cast<int32_t>(std::lround(glyph.x * 256.0f));
-    int32_t gy = static_cast<int32_t>(std::lround(glyph.y * 256.0f));
-    batch.glyphs.glyphXQ8_8.push_back(gx);
-    batch.glyphs.glyphYQ8_8.push_back(gy);
-    batch.glyphs.bitmapIndex.push_back(bitmapIndex);
+    uint32_t glyphCount = static_cast<uint32_t>(batch.glyphs.glyphXQ8_8.size()) - glyphStart;
+    runIndex = static_cast<uint32_t>(batch.runs.glyphStart.size());
+    batch.runs.glyphStart.push_back(glyphStart);
+    batch.runs.glyphCount.push_back(glyphCount);
+    batch.runs.baselineQ8_8.push_back(baselineQ8_8);
+    batch.runs.scaleQ8_8.push_back(scaleQ8_8);
+    batch.runs.glyphScaleQ8_8.push_back(glyphScaleQ8_8);
+    if (run.contentHash != 0) {
+      batch.runs.bakedLookup.insert_or_assign(
+          bakeKey, TextRunStore::BakedRun{runIndex, batch.glyphs.placementGeneration});
+    }
   }
 
-  uint32_t glyphCount = static_cast<uint32_t>(batch.glyphs.glyphXQ8_8.size()) - glyphStart;
-  uint32_t runIndex = static_cast<uint32_t>(batch.runs.glyphStart.size());
-  batch.runs.glyphStart.push_back(glyphStart);
-  batch.runs.glyphCount.push_back(glyphCount);
-  batch.runs.baselineQ8_8.push_back(static_cast<int16_t>(std::lround(run.baseline * 256.0f)));
-  float scale = run.layoutScale > 0.0f ? run.layoutScale : 1.0f;
-  batch.runs.scaleQ8_8.push_back(clamp_u16(static_cast<uint32_t>(std::lround(scale * 256.0f))));
+  if (batch.runs.used.size() <= runIndex) {
+    batch.runs.used.resize(static_cast<size_t>(runIndex) + 1u, 0u);
+  }
+  batch.runs.used[runIndex] = 1u;
+
+  if ((flags & TextFlagSprite) != 0u) {
+    BuildTextRunSprite(batch, runIndex);
+  }
 
   uint32_t widthPx = static_cast<uint32_t>(std::ceil(std::max(0.0f, run.width) * scale));
   uint32_t heightPx = static_cast<uint32_t>(std::ceil(std::max(0.0f, run.height) * scale));
@@ -128,6 +260,205 @@ auto AppendTextRun(RenderBatch& batch,
   return TextBakeResult{textIndex, runIndex};
 }
 
+auto TrimTextRuns(RenderBatch& batch) -> size_t {
+  constexpr uint32_t Dropped = std::numeric_limits<uint32_t>::max();
+  auto& runs = batch.runs;
+  auto& glyphs = batch.glyphs;
+  size_t runCount = std::min({runs.glyphStart.size(), runs.glyphCount.size(), runs.baselineQ8_8.size(),
+                              runs.scaleQ8_8.size(), runs.glyphScaleQ8_8.size()});
+  size_t placementCount = std::min({glyphs.glyphXQ8_8.size(), glyphs.glyphYQ8_8.size(), glyphs.bitmapIndex.size()});
+
+  std::vector<uint8_t> keep(runCount, 0u);
+  for (size_t i = 0; i < runCount; ++i) {
+    keep[i] = i >= runs.used.size() || runs.used[i] != 0u ? 1u : 0u;
+  }
+  for (uint32_t runIndex : batch.text.runIndex) {
+    if (runIndex < runCount) keep[runIndex] = 1u;
+  }
+
+  std::vector<uint32_t> runRemap(runCount, Dropped);
+  std::vector<uint32_t> bitmapRemap(glyphs.bitmaps.size(), Dropped);
+  std::vector<int32_t> glyphX;
+  std::vector<int32_t> glyphY;
+  std::vector<uint32_t> bitmapIndex;
+  TextRunStore kept;
+  for (size_t i = 0; i < runCount; ++i) {
+    if (!keep[i]) continue;
+    runRemap[i] = static_cast<uint32_t>(kept.glyphStart.size());
+    size_t start = std::min<size_t>(runs.glyphStart[i], placementCount);
+    size_t end = std::min<size_t>(start + runs.glyphCount[i], placementCount);
+    kept.glyphStart.push_back(static_cast<uint32_t>(glyphX.size()));
+    kept.glyphCount.push_back(static_cast<uint32_t>(end - start));
+    kept.baselineQ8_8.push_back(runs.baselineQ8_8[i]);
+    kept.scaleQ8_8.push_back(runs.scaleQ8_8[i]);
+    kept.glyphScaleQ8_8.push_back(runs.glyphScaleQ8_8[i]);
+    uint32_t sprite = i < runs.spriteIndex.size() ? runs.spriteIndex[i] : TextRunStore::NoSprite;
+    if (sprite < runs.sprites.size()) {
+      kept.spriteIndex.resize(kept.glyphStart.size(), TextRunStore::NoSprite);
+      kept.spriteIndex.back() = static_cast<uint32_t>(kept.sprites.size());
+      kept.sprites.push_back(std::move(runs.sprites[sprite]));
+    }
+    for (size_t gi = start; gi < end; ++gi) {
+      uint32_t bitmap = glyphs.bitmapIndex[gi];
+      if (bitmap < bitmapRemap.size()) bitmapRemap[bitmap] = 0u;
+      glyphX.push_back(glyphs.glyphXQ8_8[gi]);
+      glyphY.push_back(glyphs.glyphYQ8_8[gi]);
+      bitmapIndex.push_back(bitmap);
+    }
+  }
+  size_t droppedRuns = runCount - kept.glyphStart.size();
+
+  std::vector<GlyphStore::GlyphBitmap> bitmaps;
+  std::vector<uint8_t> bitmapOpaque;
+  for (size_t i = 0; i < bitmapRemap.size(); ++i) {
+    if (bitmapRemap[i] == Dropped) continue;
+    bitmapRemap[i] = static_cast<uint32_t>(bitmaps.size());
+    bitmaps.push_back(std::move(glyphs.bitmaps[i]));
+    bitmapOpaque.push_back(i < glyphs.bitmapOpaque.size() ? glyphs.bitmapOpaque[i] : 0u);
+  }
+  for (uint32_t& bitmap : bitmapIndex) {
+    if (bitmap < bitmapRemap.size()) bitmap = bitmapRemap[bitmap];
+  }
+  for (auto it = glyphs.bitmapLookup.begin(); it != glyphs.bitmapLookup.end();) {
+    if (it->second < bitmapRemap.size() && bitmapRemap[it->second] != Dropped) {
+      it->second = bitmapRemap[it->second];
+      ++it;
+    } else {
+      it = glyphs.bitmapLookup.erase(it);
+    }
+  }
+  for (auto it = runs.bakedLookup.begin(); it != runs.bakedLookup.end();) {
+    if (it->second.placementGeneration == glyphs.placementGeneration && it->second.runIndex < runCount &&
+        runRemap[it->second.runIndex] != Dropped) {
+      it->second.runIndex = runRemap[it->second.runIndex];
+      ++it;
+    } else {
+      it = runs.bakedLookup.erase(it);
+    }
+  }
+  for (uint32_t& runIndex : batch.text.runIndex) {
+    if (runIndex < runCount) runIndex = runRemap[runIndex];
+  }
+
+  kept.bakedLookup = std::move(runs.bakedLookup);
+  kept.used.assign(kept.glyphStart.size(), 0u);
+  runs = std::move(kept);
+  glyphs.glyphXQ8_8 = std::move(glyphX);
+  glyphs.glyphYQ8_8 = std::move(glyphY);
+  glyphs.bitmapIndex = std::move(bitmapIndex);
+  glyphs.bitmaps = std::move(bitmaps);
+  glyphs.bitmapOpaque = std::move(bitmapOpaque);
+  return droppedRuns;
+}
+
+auto BuildTextRunSprite(RenderBatch& batch, uint32_t runIndex) -> bool {
+  auto& runs = batch.runs;
+  if (runIndex >= runs.glyphStart.size() ||
+      runIndex >= runs.glyphCount.size() ||
+      runIndex >= runs.baselineQ8_8.size() ||
+      runIndex >= runs.scaleQ8_8.size()) {
+    return false;
+  }
+  if (runIndex < runs.spriteIndex.size() && runs.spriteIndex[runIndex] < runs.sprites.size()) return true;
+
+  uint32_t glyphStart = runs.glyphStart[runIndex];
+  uint32_t glyphEnd = glyphStart + runs.glyphCount[runIndex];
+  auto const& glyphs = batch.glyphs;
+  if (glyphEnd > glyphs.glyphXQ8_8.size() ||
+      glyphEnd > glyphs.glyphYQ8_8.size() ||
+      glyphEnd > glyphs.bitmapIndex.size()) {
+    return false;
+  }
+  float baseline = static_cast<float>(runs.baselineQ8_8[runIndex]) / 256.0f;
+  float scale = static_cast<float>(runs.scaleQ8_8[runIndex]) / 256.0f;
+  if (scale <= 0.0f) return false;
+
+  struct Placed {
+    GlyphStore::GlyphBitmap const* bmp = nullptr;
+    uint8_t const* src = nullptr;
+    int32_t stride = 0;
+    int32_t x = 0;
+    int32_t y = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+  };
+  std::vector<Placed> placed;
+  placed.reserve(glyphEnd - glyphStart);
+  int32_t minX = std::numeric_limits<int32_t>::max();
+  int32_t minY = std::numeric_limits<int32_t>::max();
+  int32_t maxX = std::numeric_limits<int32_t>::min();
+  int32_t maxY = std::numeric_limits<int32_t>::min();
+  for (uint32_t gi = glyphStart; gi < glyphEnd; ++gi) {
+    uint32_t bitmapIndex = glyphs.bitmapIndex[gi];
+    if (bitmapIndex >= glyphs.bitmaps.size()) continue;
+    auto const& bmp = glyphs.bitmaps[bitmapIndex];
+    if (bmp.width <= 0 || bmp.height <= 0) continue;
+    if (bmp.format != GlyphBitmapFormat::Mask8) return false;
+    Placed p;
+    p.bmp = &bmp;
+    p.stride = bmp.stride;
+    if (has_mask_spans(bmp)) {
+      p.src = bmp.maskSpans.data();
+      p.stride = 1;
+    } else if (bmp.atlasIndex >= 0 && bmp.atlasIndex < static_cast<int32_t>(glyphs.atlases.size())) {
+      auto const& atlas = glyphs.atlases[static_cast<size_t>(bmp.atlasIndex)];
+      p.stride = atlas.stride;
+      p.src = atlas.pixels.data() + static_cast<size_t>(bmp.atlasY) * p.stride + static_cast<size_t>(bmp.atlasX);
+    } else {
+      if (bmp.pixels.size() < static_cast<size_t>(bmp.stride) * static_cast<size_t>(bmp.height)) continue;
+      p.src = bmp.pixels.data();
+    }
+    if (!p.src || p.stride <= 0) continue;
+    // Same rounding as the per-glyph kernel's lround() for on-screen (non-negative) origins.
+    float gx = static_cast<float>(glyphs.glyphXQ8_8[gi]) / 256.0f;
+    float gy = static_cast<float>(glyphs.glyphYQ8_8[gi]) / 256.0f;
+    float subpixelShift = static_cast<float>(bmp.subpixelBin) / static_cast<float>(GlyphSubpixelBins);
+    p.x = static_cast<int32_t>(std::floor(gx * scale + static_cast<float>(bmp.bearingX) - subpixelShift + 0.5f));
+    p.y = static_cast<int32_t>(std::floor(baseline * scale + gy * scale - static_cast<float>(bmp.bearingY) + 0.5f));
+    p.width = bmp.width;
+    p.height = bmp.height;
+    minX = std::min(minX, p.x);
+    minY = std::min(minY, p.y);
+    maxX = std::max(maxX, p.x + p.width);
+    maxY = std::max(maxY, p.y + p.height);
+    placed.push_back(p);
+  }
+  if (placed.empty()) return false;
+
+  TextRunStore::Sprite sprite;
+  sprite.x = minX;
+  sprite.y = minY;
+  sprite.width = maxX - minX;
+  sprite.height = maxY - minY;
+  sprite.coverage.assign(static_cast<size_t>(sprite.width) * static_cast<size_t>(sprite.height), 0u);
+  // Overlapping glyphs merge as a + b - ab, the coverage two successive source-over blends produce.
+  std::vector<uint8_t> decoded;
+  for (auto const& p : placed) {
+    bool spans = has_mask_spans(*p.bmp);
+    for (int32_t y = 0; y < p.height; ++y) {
+      uint8_t const* src = p.src + static_cast<size_t>(y) * p.stride;
+      if (spans) {
+        decode_mask_span_row(*p.bmp, y, decoded);
+        src = decoded.data();
+      }
+      uint8_t* dst = sprite.coverage.data() + static_cast<size_t>(p.y - minY + y) * sprite.width +
+                     static_cast<size_t>(p.x - minX);
+      for (int32_t x = 0; x < p.width; ++x) {
+        uint32_t a = dst[x];
+        uint32_t b = src[x];
+        dst[x] = static_cast<uint8_t>(a + b - (a * b + 127u) / 255u);
+      }
+    }
+  }
+
+  if (runs.spriteIndex.size() < runs.glyphStart.size()) {
+    runs.spriteIndex.resize(runs.glyphStart.size(), TextRunStore::NoSprite);
+  }
+  runs.spriteIndex[runIndex] = static_cast<uint32_t>(runs.sprites.size());
+  runs.sprites.push_back(std::move(sprite));
+  return true;
+}
+
 auto AppendText(RenderBatch& batch,
                 std::string_view text,
                 Typography const& typography,
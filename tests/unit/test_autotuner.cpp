@@ -0,0 +1,166 @@
+#include "PrimeManifest/renderer/Autotuner.hpp"
+#include "PrimeManifest/renderer/Optimizer2D.hpp"
+
+#include "test_helpers.hpp"
+#include "third_party/doctest.h"
+
+#include <array>
+#include <filesystem>
+
+using namespace PrimeManifest;
+using namespace PrimeManifestTest;
+
+namespace {
+
+auto build_tuning_scene() -> RenderBatch {
+  RenderBatch batch;
+  batch.assumeFrontToBack = false;
+  add_clear(batch, PackRGBA8(Color{8, 8, 8, 255}));
+  for (int i = 0; i < 12; ++i) {
+    add_rect(batch, i * 5, i * 3, i * 5 + 20, i * 3 + 14, PackRGBA8(Color{uint8_t(20 * i), 90, 40, 255}));
+  }
+  add_circle(batch, 30, 30, 9, PackRGBA8(Color{220, 70, 30, 255}));
+  return batch;
+}
+
+} // namespace
+
+TEST_SUITE_BEGIN("primemanifest.autotuner");
+
+TEST_CASE("autotuner_samples_candidates_and_settles_on_fastest") {
+  RenderAutotuner tuner;
+  std::array<uint16_t, 2> sizes{16, 32};
+  tuner.setCandidateTileSizes(sizes);
+  tuner.setSampleFrames(2);
+
+  RenderBatch batch = build_tuning_scene();
+  RendererProfile profile;
+  batch.profile = &profile;
+  batch.reuseOptimized = true;
+
+  std::array<std::pair<uint16_t, bool>, 4> expected{{{16, true}, {16, false}, {32, true}, {32, false}}};
+  for (auto const& [tileSize, autoTileStream] : expected) {
+    for (int frame = 0; frame < 2; ++frame) {
+      CHECK_MESSAGE(!tuner.settled(batch, 64, 64), "still sampling");
+      tuner.apply(batch, 64, 64);
+      CHECK_MESSAGE(batch.tileSize == tileSize, "candidate tile size applied");
+      CHECK_MESSAGE(batch.autoTileStream == autoTileStream, "candidate tile-stream mode applied");
+      CHECK_MESSAGE(!batch.reuseOptimized, "sampling rebuilds the optimized batch");
+      bool fastest = tileSize == 32 && !autoTileStream;
+      profile.buildNs = 1000;
+      profile.renderNs = fastest ? 500 + frame : 4000 - frame;
+      tuner.record(batch);
+      CHECK_MESSAGE(batch.reuseOptimized, "caller reuse flag restored");
+      CHECK_MESSAGE(batch.profile == &profile, "caller profile kept");
+    }
+  }
+
+  auto choice = tuner.settled(batch, 64, 64);
+  REQUIRE(choice);
+  CHECK(choice->tileSize == 32);
+  CHECK(!choice->autoTileStream);
+
+  batch.tileSize = 8;
+  batch.autoTileStream = true;
+  tuner.apply(batch, 64, 64);
+  CHECK_MESSAGE(batch.tileSize == 32, "settled tile size applied");
+  CHECK_MESSAGE(!batch.autoTileStream, "settled mode applied");
+  CHECK_MESSAGE(!tuner.settled(batch, 640, 480), "other target sizes tune separately");
+}
+
+TEST_CASE("autotuner_scores_reusing_callers_on_render_time") {
+  std::array<uint16_t, 2> sizes{16, 32};
+  for (bool reuse : {false, true}) {
+    CAPTURE(reuse);
+    RenderAutotuner tuner;
+    tuner.setCandidateTileSizes(sizes);
+    tuner.setSampleFrames(1);
+
+    RenderBatch batch = build_tuning_scene();
+    RendererProfile profile;
+    batch.profile = &profile;
+    batch.reuseOptimized = reuse;
+    for (int frame = 0; frame < 4; ++frame) {
+      tuner.apply(batch, 64, 64);
+      // Tile size 16 renders fastest but costs far more to build.
+      bool small = batch.tileSize == 16;
+      profile.buildNs = small ? 9000 : 1000;
+      profile.renderNs = small ? 2000 : 3000;
+      tuner.record(batch);
+    }
+    auto choice = tuner.settled(batch, 64, 64);
+    REQUIRE(choice);
+    CHECK(choice->tileSize == (reuse ? 16 : 32));
+  }
+}
+
+TEST_CASE("autotuner_measures_real_frames_and_persists_decisions") {
+  RenderAutotuner tuner;
+  tuner.setSampleFrames(1);
+  RenderBatch batch = build_tuning_scene();
+  std::vector<uint8_t> expected(64 * 64 * 4, 0);
+  render_batch(RenderTarget{std::span<uint8_t>(expected), 64, 64, 64 * 4}, batch);
+
+  std::vector<uint8_t> buffer(64 * 64 * 4, 0);
+  RenderTarget target{std::span<uint8_t>(buffer), 64, 64, 64 * 4};
+  OptimizedBatch optimized;
+  for (int frame = 0; frame < 8; ++frame) {
+    tuner.apply(batch, 64, 64);
+    OptimizeRenderBatch(target, batch, optimized);
+    RenderOptimized(target, batch, optimized);
+    tuner.record(batch);
+    CHECK_MESSAGE(batch.profile == nullptr, "internal profile detached after each frame");
+    CHECK_MESSAGE(buffer == expected, "every candidate renders the same pixels");
+  }
+  auto choice = tuner.settled(batch, 64, 64);
+  REQUIRE(choice);
+
+  std::filesystem::path path = std::filesystem::temp_directory_path() / "primemanifest_autotune.bin";
+  REQUIRE(tuner.save(path.string()));
+  RenderAutotuner restored;
+  REQUIRE(restored.load(path.string()));
+  CHECK(restored.settledCount() == 1);
+  auto loaded = restored.settled(batch, 64, 64);
+  REQUIRE(loaded);
+  CHECK(loaded->tileSize == choice->tileSize);
+  CHECK(loaded->autoTileStream == choice->autoTileStream);
+  std::filesystem::remove(path);
+
+  CHECK_MESSAGE(!restored.load(path.string()), "missing file reports failure");
+}
+
+TEST_CASE("autotuner_settled_stream_mode_rebuilds_reused_batch") {
+  RenderAutotuner tuner;
+  std::array<uint16_t, 1> sizes{16};
+  tuner.setCandidateTileSizes(sizes);
+  tuner.setSampleFrames(1);
+
+  RenderBatch batch = build_tuning_scene();
+  RendererProfile profile;
+  batch.profile = &profile;
+  batch.reuseOptimized = true;
+  batch.revision = 3;
+
+  std::vector<uint8_t> buffer(64 * 64 * 4, 0);
+  RenderTarget target{std::span<uint8_t>(buffer), 64, 64, 64 * 4};
+  OptimizedBatch optimized;
+  for (int frame = 0; frame < 2; ++frame) {
+    tuner.apply(batch, 64, 64);
+    OptimizeRenderBatch(target, batch, optimized);
+    profile.buildNs = 1000;
+    profile.renderNs = batch.autoTileStream ? 500 : 4000;
+    tuner.record(batch);
+  }
+  REQUIRE(optimized.valid);
+  CHECK_MESSAGE(!optimized.useTileStream, "sampling ended on the stream-off candidate");
+  auto choice = tuner.settled(batch, 64, 64);
+  REQUIRE(choice);
+  REQUIRE(choice->autoTileStream);
+
+  tuner.apply(batch, 64, 64);
+  REQUIRE(batch.reuseOptimized);
+  OptimizeRenderBatch(target, batch, optimized);
+  CHECK_MESSAGE(optimized.useTileStream, "settled stream mode applied despite unchanged revision");
+}
+
+TEST_SUITE_END();
@@ -107,4 +107,30 @@ TEST_CASE("convert_invalid_format_fails") {
   CHECK_MESSAGE(!ConvertFontBitmapToAlpha(view, out, stride), "invalid format fails");
 }
 
+TEST_CASE("distance_field_square") {
+  std::vector<uint8_t> coverage(16, 255);
+  std::vector<uint8_t> field;
+  int32_t fieldWidth = 0;
+  int32_t fieldHeight = 0;
+  CHECK_MESSAGE(BuildGlyphDistanceField(coverage.data(), 4, 4, 4, 2, field, fieldWidth, fieldHeight),
+                "distance field builds");
+  CHECK_MESSAGE(fieldWidth == 8, "distance field pads width");
+  CHECK_MESSAGE(fieldHeight == 8, "distance field pads height");
+  CHECK_MESSAGE(field.size() == 64, "distance field output size");
+  CHECK_MESSAGE(field[3 * 8 + 3] > 128, "interior is positive");
+  CHECK_MESSAGE(field[0] < 64, "far corner is outside");
+  CHECK_MESSAGE(field[3 * 8 + 2] > field[3 * 8 + 1], "distance increases toward the outline");
+  CHECK_MESSAGE(field[3 * 8 + 3] > field[3 * 8 + 2], "distance increases past the outline");
+}
+
+TEST_CASE("distance_field_rejects_invalid_input") {
+  std::vector<uint8_t> field;
+  int32_t fieldWidth = 0;
+  int32_t fieldHeight = 0;
+  uint8_t pixel = 255;
+  CHECK_MESSAGE(!BuildGlyphDistanceField(nullptr, 1, 1, 1, 2, field, fieldWidth, fieldHeight), "null coverage fails");
+  CHECK_MESSAGE(!BuildGlyphDistanceField(&pixel, 1, 1, 1, 0, field, fieldWidth, fieldHeight), "zero spread fails");
+  CHECK_MESSAGE(field.empty(), "failed build leaves output empty");
+}
+
 TEST_SUITE_END();
@@ -1,12 +1,15 @@
 #include "PrimeManifest/text/FontRegistry.hpp"
+#include "PrimeManifest/text/TextBake.hpp"
 #include "PrimeManifest/util/BitmapFont.hpp"
 
 #include "third_party/doctest.h"
 
+#include <cmath>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <optional>
+#include <string_view>
 #include <vector>
 
 using namespace PrimeManifest;
@@ -63,6 +66,18 @@ auto find_system_font_file() -> std::optional<std::filesystem::path> {
   return std::nullopt;
 }
 
+auto find_font_file_named(std::string_view name) -> std::optional<std::filesystem::path> {
+  for (auto const& dir : default_font_dirs()) {
+    std::error_code ec;
+    if (!std::filesystem::exists(dir, ec)) continue;
+    for (auto const& entry : std::filesystem::recursive_directory_iterator(dir, ec)) {
+      if (ec) break;
+      if (entry.path().filename() == name) return entry.path();
+    }
+  }
+  return std::nullopt;
+}
+
 auto write_psfont(std::filesystem::path const& bundlePath,
                   std::filesystem::path const& fontPath) -> bool {
   std::ifstream input(fontPath, std::ios::binary);
@@ -94,6 +109,18 @@ auto write_psfont(std::filesystem::path const& bundlePath,
   return static_cast<bool>(output);
 }
 
+auto glyph_pixels(GlyphBitmap const& bitmap) -> std::vector<uint8_t> {
+  std::vector<uint8_t> out;
+  int32_t rowBytes = bitmap.format == GlyphBitmapFormat::ColorBGRA ? bitmap.width * 4 : bitmap.width;
+  for (int32_t y = 0; y < bitmap.height; ++y) {
+    const uint8_t* row = bitmap.atlas
+                           ? bitmap.atlas->pixels.data() + static_cast<size_t>(bitmap.atlasY + y) * bitmap.stride + bitmap.atlasX
+                           : bitmap.pixels.data() + static_cast<size_t>(y) * bitmap.stride;
+    out.insert(out.end(), row, row + rowBytes);
+  }
+  return out;
+}
+
 } // namespace
 
 TEST_SUITE_BEGIN("primemanifest.font_registry");
@@ -204,6 +231,258 @@ TEST_CASE("layout_text_spacing_increases_width") {
   CHECK_MESSAGE(spacedRun->width >= baseRun->width, "spacing widens run");
 }
 
+TEST_CASE("layout_text_distance_field_shares_glyphs_across_sizes") {
+  FontRegistry registry;
+  Typography small;
+  small.size = 12.0f;
+  small.distanceField = true;
+  Typography large = small;
+  large.size = 36.0f;
+
+  auto smallRun = registry.layoutText("e", small, 1.0f, true);
+  auto largeRun = registry.layoutText("e", large, 2.0f, true);
+  if (!smallRun || !largeRun) return;
+  if (smallRun->glyphs.empty() || largeRun->glyphs.empty()) return;
+  auto const* bitmap = smallRun->glyphs[0].bitmap;
+  CHECK_MESSAGE(bitmap, "distance field glyph produced");
+  if (!bitmap) return;
+  CHECK_MESSAGE(bitmap->format == GlyphBitmapFormat::Sdf8, "distance field glyph format");
+  CHECK_MESSAGE(largeRun->glyphs[0].bitmap == bitmap, "glyph bitmap shared across sizes");
+  CHECK_MESSAGE(smallRun->glyphScale == doctest::Approx(12.0f / GlyphSdfReferenceSize), "small glyph scale");
+  CHECK_MESSAGE(largeRun->glyphScale == doctest::Approx(72.0f / GlyphSdfReferenceSize), "large glyph scale");
+}
+
+TEST_CASE("layout_text_subpixel_variants_follow_pen_fraction") {
+  FontRegistry registry;
+  Typography typography;
+  typography.size = 13.0f;
+  typography.subpixelPositioning = true;
+
+  auto run = registry.layoutText("iiiiiiii", typography, 1.0f, true);
+  if (!run) return;
+  for (auto const& glyph : run->glyphs) {
+    if (!glyph.bitmap || glyph.bitmap->width <= 0) continue;
+    long quarter = std::lround(glyph.x * static_cast<float>(GlyphSubpixelBins));
+    auto expected = static_cast<uint8_t>(quarter % GlyphSubpixelBins);
+    CHECK_MESSAGE(glyph.bitmap->subpixelBin == expected, "variant matches quantized pen fraction");
+  }
+}
+
+TEST_CASE("layout_text_content_hash_tracks_bitmap_variants") {
+  FontRegistry registry;
+  Typography whole;
+  whole.size = 13.0f;
+  Typography subpixel = whole;
+  subpixel.subpixelPositioning = true;
+
+  auto plain = registry.layoutText("iiiiiiii", whole, 1.0f, true);
+  auto binned = registry.layoutText("iiiiiiii", subpixel, 1.0f, true);
+  if (!plain || !binned || plain->glyphs.empty()) return;
+  CHECK_MESSAGE(plain->contentHash != binned->contentHash, "subpixel variants hash differently");
+
+  RenderBatch batch;
+  auto first = AppendTextRun(batch, *plain, 0, 0, 0);
+  auto second = AppendTextRun(batch, *binned, 0, 0, 0);
+  REQUIRE(first);
+  REQUIRE(second);
+  CHECK_MESSAGE(first->runIndex != second->runIndex, "toggling subpixel positioning bakes a new run");
+
+  Typography sdf = whole;
+  sdf.distanceField = true;
+  auto field = registry.layoutText("iiiiiiii", sdf, 1.0f, true);
+  if (!field) return;
+  CHECK_MESSAGE(field->contentHash != plain->contentHash, "distance-field runs hash differently");
+}
+
+TEST_CASE("glyph_bitmap_identity_is_stable_and_unique_per_registry") {
+  Typography typography;
+  typography.size = 13.0f;
+  FontRegistry registry;
+  FontRegistry other;
+  auto first = registry.layoutText("Aa", typography, 1.0f, true);
+  auto again = registry.layoutText("Aa", typography, 1.0f, true);
+  auto elsewhere = other.layoutText("Aa", typography, 1.0f, true);
+  if (!first || !again || !elsewhere) return;
+  REQUIRE(first->glyphs.size() == elsewhere->glyphs.size());
+  for (size_t i = 0; i < first->glyphs.size(); ++i) {
+    if (!first->glyphs[i].bitmap || !elsewhere->glyphs[i].bitmap) continue;
+    CHECK(first->glyphs[i].bitmap->identity.registry != 0u);
+    CHECK(first->glyphs[i].bitmap->identity == again->glyphs[i].bitmap->identity);
+    CHECK_MESSAGE(first->glyphs[i].bitmap->identity != elsewhere->glyphs[i].bitmap->identity,
+                  "another registry's glyphs never alias");
+  }
+  if (first->glyphs.size() == 2 && first->glyphs[0].bitmap && first->glyphs[1].bitmap) {
+    CHECK(first->glyphs[0].bitmap->identity != first->glyphs[1].bitmap->identity);
+  }
+}
+
+TEST_CASE("layout_text_runs_from_different_registries_never_share_a_bake") {
+  Typography typography;
+  typography.size = 13.0f;
+  FontRegistry registry;
+  FontRegistry other;
+  auto first = registry.layoutText("Aa", typography, 1.0f, true);
+  auto second = other.layoutText("Aa", typography, 1.0f, true);
+  if (!first || !second || first->glyphs.empty()) return;
+  CHECK(first->contentHash != second->contentHash);
+
+  RenderBatch batch;
+  auto a = AppendTextRun(batch, *first, 0, 0, 0);
+  size_t bitmapsAfterFirst = batch.glyphs.bitmaps.size();
+  auto b = AppendTextRun(batch, *second, 0, 0, 0);
+  REQUIRE(a);
+  REQUIRE(b);
+  CHECK_MESSAGE(a->runIndex != b->runIndex, "a run from another registry is baked, not reused");
+  CHECK_MESSAGE(batch.glyphs.bitmaps.size() > bitmapsAfterFirst, "it references its own registry's bitmaps");
+}
+
+TEST_CASE("layout_text_itemizes_across_unicode_planes") {
+  FontRegistry registry;
+  registry.loadBundledFonts();
+  if (!registry.hasBundledFaces()) return;
+
+  Typography typography;
+  typography.size = 14.0f;
+  typography.fallback = FontFallbackPolicy::BundleOnly;
+  // Latin, CJK, the last valid codepoint and an out-of-range 4-byte sequence.
+  std::string_view text = "a\xE4\xB8\x80\xF4\x8F\xBF\xBF\xF7\xBF\xBF\xBF";
+  auto first = registry.layoutText(text, typography, 1.0f, false);
+  REQUIRE(first);
+  CHECK_MESSAGE(first->glyphs.size() >= 4, "every codepoint is itemized");
+  auto second = registry.layoutText(text, typography, 1.0f, false);
+  REQUIRE(second);
+  CHECK_MESSAGE(second->contentHash == first->contentHash, "cached pages resolve identically");
+}
+
+TEST_CASE("layout_text_alternating_sizes_is_stable") {
+  FontRegistry registry;
+  Typography small;
+  small.size = 12.0f;
+  Typography large;
+  large.size = 20.0f;
+
+  auto first = registry.layoutText("Sized label", small, 1.0f, true);
+  auto middle = registry.layoutText("Sized label", large, 1.0f, true);
+  auto again = registry.layoutText("Sized label", small, 1.0f, true);
+  if (!first || !middle || !again) return;
+  CHECK_MESSAGE(again->contentHash == first->contentHash, "cached size shapes identically");
+  CHECK_MESSAGE(again->width == doctest::Approx(first->width), "cached size keeps metrics");
+  CHECK_MESSAGE(middle->width > first->width, "larger size is wider");
+
+  FontRegistry fresh;
+  auto reference = fresh.layoutText("Sized label", large, 1.0f, true);
+  REQUIRE(reference);
+  REQUIRE_MESSAGE(middle->glyphs.size() == reference->glyphs.size(), "size switch matches a fresh registry");
+  for (size_t i = 0; i < middle->glyphs.size(); ++i) {
+    CHECK(middle->glyphs[i].glyphId == reference->glyphs[i].glyphId);
+    CHECK(middle->glyphs[i].x == reference->glyphs[i].x);
+    CHECK(middle->glyphs[i].y == reference->glyphs[i].y);
+  }
+}
+
+TEST_CASE("latin_fast_path_matches_harfbuzz") {
+  FontRegistry fast;
+  FontRegistry shaped;
+  shaped.setLatinFastPathEnabled(false);
+
+  std::vector<std::string_view> corpus = {
+    "Hello, World!",
+    "AVATAR Tokyo WAVE yo Te",
+    "office affine fjord",
+    "The quick brown fox jumps over the lazy dog 0123456789",
+    "(x + y) * z = {a[0]}; // ~`^_|\\",
+    "12:30 - 14:45",
+    "  leading and trailing  ",
+    "Mixed caf\xC3\xA9 text",
+  };
+  for (float size : {9.0f, 13.0f, 24.0f}) {
+    for (uint16_t weight : {uint16_t{400}, uint16_t{700}}) {
+      Typography typography;
+      typography.size = size;
+      typography.weight = weight;
+      typography.letterSpacing = 0.02f;
+      for (auto text : corpus) {
+        auto a = fast.layoutText(text, typography, 1.5f, true);
+        auto b = shaped.layoutText(text, typography, 1.5f, true);
+        if (!a || !b) continue;
+        REQUIRE_MESSAGE(a->glyphs.size() == b->glyphs.size(), "glyph count for: " << text);
+        for (size_t i = 0; i < a->glyphs.size(); ++i) {
+          CHECK(a->glyphs[i].glyphId == b->glyphs[i].glyphId);
+          CHECK(a->glyphs[i].x == b->glyphs[i].x);
+          CHECK(a->glyphs[i].y == b->glyphs[i].y);
+          CHECK(a->glyphs[i].advance == b->glyphs[i].advance);
+          CHECK(a->glyphs[i].cluster == b->glyphs[i].cluster);
+        }
+        CHECK(a->width == b->width);
+      }
+    }
+  }
+}
+
+TEST_CASE("prewarm_glyphs_matches_on_demand_rasterization") {
+  FontRegistry warmed;
+  FontRegistry cold;
+
+  std::vector<std::string_view> samples = {"Prewarm glyphs 0123", "xyz"};
+  std::vector<Typography> typographies(3);
+  typographies[0].size = 13.0f;
+  typographies[1].size = 18.0f;
+  typographies[1].weight = 700;
+  typographies[2].size = 15.0f;
+  typographies[2].subpixelPositioning = true;
+  warmed.prewarmGlyphs(samples, typographies, 1.0f);
+
+  for (auto const& typography : typographies) {
+    for (auto sample : samples) {
+      auto a = warmed.layoutText(sample, typography, 1.0f, true);
+      auto b = cold.layoutText(sample, typography, 1.0f, true);
+      if (!a || !b) continue;
+      REQUIRE(a->glyphs.size() == b->glyphs.size());
+      for (size_t i = 0; i < a->glyphs.size(); ++i) {
+        auto const* ga = a->glyphs[i].bitmap;
+        auto const* gb = b->glyphs[i].bitmap;
+        REQUIRE((ga == nullptr) == (gb == nullptr));
+        if (!ga) continue;
+        CHECK(ga->width == gb->width);
+        CHECK(ga->height == gb->height);
+        CHECK(ga->bearingX == gb->bearingX);
+        CHECK(ga->bearingY == gb->bearingY);
+        CHECK(ga->subpixelBin == gb->subpixelBin);
+        CHECK(glyph_pixels(*ga) == glyph_pixels(*gb));
+      }
+    }
+  }
+
+  auto first = warmed.layoutText("xyz", typographies[0], 1.0f, true);
+  auto second = warmed.layoutText("xyz", typographies[0], 1.0f, true);
+  if (first && second && !first->glyphs.empty()) {
+    CHECK_MESSAGE(first->glyphs[0].bitmap == second->glyphs[0].bitmap, "prewarmed glyph is cached");
+  }
+}
+
+TEST_CASE("measure_texts_matches_single_measure") {
+  FontRegistry registry;
+  Typography typography;
+  typography.size = 13.0f;
+  std::vector<std::string_view> cells = {"Name", "Quantity", "", "1234.50", "Name"};
+
+  auto batched = registry.measureTexts(cells, typography);
+  CHECK_MESSAGE(batched.size() == cells.size(), "one measurement per string");
+  if (batched.size() != cells.size()) return;
+  for (size_t i = 0; i < cells.size(); ++i) {
+    auto single = registry.measureText(cells[i], typography);
+    CHECK_MESSAGE(batched[i] == single, "batched measure matches single measure");
+  }
+
+  Typography bitmapTypography = typography;
+  bitmapTypography.family = "bitmap";
+  auto fallback = MeasureTexts(std::span<std::string_view const>(cells.data(), 1), bitmapTypography);
+  CHECK_MESSAGE(fallback.size() == 1, "bitmap family measured");
+  if (!fallback.empty()) {
+    CHECK_MESSAGE(fallback[0] == MeasureUiText("Name", typography.size), "bitmap family falls back");
+  }
+}
+
 TEST_CASE("bundle_psfont_loads_faces") {
   auto fontPath = find_system_font_file();
   if (!fontPath) return;
@@ -228,6 +507,150 @@ TEST_CASE("bundle_psfont_loads_faces") {
   CHECK_MESSAGE(run, "layout from bundle succeeds");
 }
 
+TEST_CASE("bundle_faces_open_lazily_and_outlive_the_loader") {
+  // A family the default bundle dirs do not ship, so layout resolves to the bundle's face.
+  auto fontPath = find_font_file_named("DejaVuSans.ttf");
+  if (!fontPath) return;
+
+  std::filesystem::path tempDir = std::filesystem::temp_directory_path() / "primemanifest_font_bundle_lazy";
+  std::error_code ec;
+  std::filesystem::remove_all(tempDir, ec);
+  std::filesystem::create_directories(tempDir / "bundle", ec);
+  std::filesystem::create_directories(tempDir / "plain", ec);
+  if (ec) return;
+  if (!write_psfont(tempDir / "bundle" / "bundle.psfont", *fontPath)) return;
+  std::filesystem::copy_file(*fontPath, tempDir / "plain" / fontPath->filename(), ec);
+  if (ec) return;
+
+  Typography typography;
+  typography.family = "DejaVu Sans";
+  typography.size = 14.0f;
+  typography.fallback = FontFallbackPolicy::BundleOnly;
+
+  FontRegistry plain;
+  plain.addBundleDir((tempDir / "plain").string());
+  auto reference = plain.layoutText("Lazy glyphs", typography, 1.0f, true);
+  REQUIRE(reference);
+
+  for (bool mapped : {true, false}) {
+    CAPTURE(mapped);
+    FontRegistry registry;
+    registry.setFontFileMappingEnabled(mapped);
+    registry.addBundleDir((tempDir / "bundle").string());
+    registry.loadBundledFonts();
+    FontFaceStats loaded = registry.faceStats();
+    REQUIRE(loaded.registered >= 1);
+    CHECK_MESSAGE(loaded.opened == 0, "bundle load registers faces without opening them");
+    if (mapped) {
+      CHECK(loaded.mappedFiles >= 1);
+    } else {
+      CHECK_MESSAGE(loaded.mappedFiles == 0, "read path copies every font file");
+      CHECK(loaded.readFiles >= 1);
+    }
+
+    auto run = registry.layoutText("Lazy glyphs", typography, 1.0f, true);
+    REQUIRE(run);
+    CHECK_MESSAGE(registry.faceStats().opened >= 1, "layout opens the faces it uses");
+
+    REQUIRE(run->glyphs.size() == reference->glyphs.size());
+    for (size_t i = 0; i < run->glyphs.size(); ++i) {
+      CHECK(run->glyphs[i].glyphId == reference->glyphs[i].glyphId);
+      CHECK(run->glyphs[i].x == reference->glyphs[i].x);
+      auto const* bitmap = run->glyphs[i].bitmap;
+      auto const* expected = reference->glyphs[i].bitmap;
+      REQUIRE((bitmap == nullptr) == (expected == nullptr));
+      if (!bitmap) continue;
+      CHECK_MESSAGE(glyph_pixels(*bitmap) == glyph_pixels(*expected), "bundle glyph rasterizes from live font data");
+    }
+  }
+}
+
+TEST_CASE("os_font_index_persists_and_reloads") {
+  auto fontPath = find_system_font_file();
+  if (!fontPath) return;
+
+  std::filesystem::path tempDir = std::filesystem::temp_directory_path() / "primemanifest_font_index";
+  std::error_code ec;
+  std::filesystem::remove_all(tempDir, ec);
+  std::filesystem::create_directories(tempDir / "fonts", ec);
+  if (ec) return;
+  std::filesystem::copy_file(*fontPath, tempDir / "fonts" / fontPath->filename(), ec);
+  if (ec) return;
+  auto indexPath = tempDir / "index.bin";
+
+  size_t indexed = 0;
+  {
+    FontRegistry registry;
+    registry.setOsFontIndexPath(indexPath.string());
+    registry.addOsFallbackDir((tempDir / "fonts").string());
+    registry.buildOsFontIndex();
+    indexed = registry.waitForOsFontIndex();
+    CHECK_MESSAGE(indexed >= 1, "index records the copied font");
+
+    Typography typography;
+    typography.size = 12.0f;
+    typography.fallback = FontFallbackPolicy::BundleThenOS;
+    auto run = registry.layoutText("Hi \xE2\x98\x83", typography, 1.0f, false);
+    CHECK_MESSAGE(run, "layout resolves through the index");
+  }
+  CHECK_MESSAGE(std::filesystem::exists(indexPath), "index persisted to disk");
+
+  FontRegistry reloaded;
+  reloaded.setOsFontIndexPath(indexPath.string());
+  reloaded.addOsFallbackDir((tempDir / "fonts").string());
+  CHECK_MESSAGE(reloaded.waitForOsFontIndex() == indexed, "reloaded index matches");
+
+  {
+    std::ofstream corrupt(indexPath, std::ios::binary | std::ios::trunc);
+    corrupt << "not an index";
+  }
+  FontRegistry rebuilt;
+  rebuilt.setOsFontIndexPath(indexPath.string());
+  rebuilt.addOsFallbackDir((tempDir / "fonts").string());
+  CHECK_MESSAGE(rebuilt.waitForOsFontIndex() == indexed, "corrupt index is rebuilt");
+}
+
+TEST_CASE("os_font_index_miss_falls_back_to_scanning") {
+  auto fontPath = find_font_file_named("DejaVuSans.ttf");
+  if (!fontPath) return;
+
+  // Sorts ahead of the system copy, so the index prefers it for the family.
+  std::filesystem::path tempDir = std::filesystem::temp_directory_path() / "primemanifest_font_index_miss";
+  std::error_code ec;
+  std::filesystem::remove_all(tempDir, ec);
+  std::filesystem::create_directories(tempDir / "fonts", ec);
+  if (ec) return;
+  auto copyPath = tempDir / "fonts" / "a.ttf";
+  std::filesystem::copy_file(*fontPath, copyPath, ec);
+  if (ec) return;
+  auto indexPath = tempDir / "index.bin";
+
+  Typography typography;
+  typography.family = "DejaVu Sans";
+  typography.size = 16.0f;
+  typography.fallback = FontFallbackPolicy::BundleThenOS;
+
+  FontRegistry scanned;
+  scanned.setOsFontIndexPath("");
+  auto reference = scanned.layoutText("Hamburgefonts", typography, 1.0f, false);
+  if (!reference) return;
+  {
+    FontRegistry registry;
+    registry.setOsFontIndexPath(indexPath.string());
+    registry.addOsFallbackDir((tempDir / "fonts").string());
+    registry.buildOsFontIndex();
+    REQUIRE(registry.waitForOsFontIndex() >= 1);
+  }
+  std::filesystem::remove(copyPath, ec);
+
+  FontRegistry stale;
+  stale.setOsFontIndexPath(indexPath.string());
+  stale.addOsFallbackDir((tempDir / "fonts").string());
+  auto run = stale.layoutText("Hamburgefonts", typography, 1.0f, false);
+  REQUIRE(run);
+  CHECK_MESSAGE(run->width == doctest::Approx(reference->width), "family still resolves from the remaining files");
+}
+
 TEST_CASE("emoji_fixed_sizes_load") {
 #if defined(__APPLE__)
   std::filesystem::path emojiPath = "/System/Library/Fonts/Apple Color Emoji.ttc";
@@ -1,8 +1,11 @@
 #include "PrimeManifest/renderer/Optimizer2D.hpp"
 
+#include "src/renderer/CommandAnalysis.hpp"
 #include "test_helpers.hpp"
 #include "third_party/doctest.h"
 
+#include <algorithm>
+
 using namespace PrimeManifest;
 using namespace PrimeManifestTest;
 
@@ -299,6 +302,375 @@ TEST_CASE("circle_binning_parallel_path") {
   CHECK_MESSAGE(optimized.tileRefs.size() >= circleCount, "tile refs include all circles");
 }
 
+TEST_CASE("parallel_command_analysis_preserves_order") {
+  RenderBatch batch;
+  batch.tileSize = 16;
+  add_clear(batch, PackRGBA8(Color{0, 0, 0, 255}));
+  uint32_t width = 256;
+  uint32_t height = 256;
+  for (uint32_t i = 0; i < 12000; ++i) {
+    int32_t x = static_cast<int32_t>((i * 37u) % 300u) - 20;
+    int32_t y = static_cast<int32_t>((i * 91u) % 300u) - 20;
+    uint8_t alpha = (i % 7 == 0) ? 0 : 255;
+    add_rect(batch, x, y, x + 3 + static_cast<int32_t>(i % 40), y + 5, PackRGBA8(Color{40, 80, 120, alpha}));
+  }
+
+  std::vector<uint8_t> buffer(width * height * 4, 0);
+  RenderTarget target{std::span<uint8_t>(buffer), width, height, width * 4};
+  OptimizedBatch optimized;
+  OptimizeRenderBatch(target, batch, optimized);
+  REQUIRE(optimized.valid);
+
+  CommandAnalysisConfig config{};
+  config.targetWidth = width;
+  config.targetHeight = height;
+  config.tileSize = optimized.tileSize;
+  config.tilePow2 = optimized.tilePow2;
+  config.tileShift = optimized.tileShift;
+  std::vector<AnalyzedCommand> serial;
+  analyzeCommands(batch, config, serial);
+  REQUIRE(optimized.cmdActive.size() == serial.size());
+  bool matches = true;
+  for (size_t i = 0; i < serial.size(); ++i) {
+    bool active = optimized.cmdActive[i] != 0u;
+    if (active != serial[i].valid || serial[i].order != i) {
+      matches = false;
+      break;
+    }
+    if (active && (optimized.cmdTiles[i].tx0 != serial[i].tx0 || optimized.cmdTiles[i].ty1 != serial[i].ty1 ||
+                   optimized.cmdTiles[i].x1 != serial[i].x1)) {
+      matches = false;
+      break;
+    }
+  }
+  CHECK_MESSAGE(matches, "parallel analysis matches the serial pass slot for slot");
+}
+
+TEST_CASE("parallel_mixed_binning_keeps_command_order") {
+  RenderBatch batch;
+  batch.tileSize = 32;
+  batch.autoTileStream = false;
+  uint32_t color = PackRGBA8(Color{90, 30, 200, 255});
+  add_clear(batch, PackRGBA8(Color{0, 0, 0, 255}));
+  uint32_t width = 320;
+  uint32_t height = 240;
+  for (uint32_t i = 0; i < 20000; ++i) {
+    int32_t x = static_cast<int32_t>((i * 53u) % width);
+    int32_t y = static_cast<int32_t>((i * 29u) % height);
+    if (i % 3 == 0) {
+      add_circle(batch, x, y, 3 + static_cast<int32_t>(i % 20), color);
+    } else {
+      add_rect(batch, x, y, x + 4 + static_cast<int32_t>(i % 60), y + 6, color);
+    }
+  }
+
+  std::vector<uint8_t> buffer(width * height * 4, 0);
+  RenderTarget target{std::span<uint8_t>(buffer), width, height, width * 4};
+  OptimizedBatch optimized;
+  OptimizeRenderBatch(target, batch, optimized);
+  REQUIRE(optimized.valid);
+  REQUIRE(!optimized.tileRefsAreCircleIndices);
+  REQUIRE(optimized.tileOffsets.size() == optimized.tileCount + 1);
+
+  uint64_t expectedRefs = 0;
+  for (size_t i = 0; i < optimized.cmdActive.size(); ++i) {
+    if (optimized.cmdActive[i] == 0u) continue;
+    auto const& info = optimized.cmdTiles[i];
+    expectedRefs += static_cast<uint64_t>(info.tx1 - info.tx0 + 1) * (info.ty1 - info.ty0 + 1);
+  }
+  CHECK_MESSAGE(optimized.tileRefs.size() == expectedRefs, "every covered tile gets one ref");
+
+  bool ordered = true;
+  bool covered = true;
+  for (uint32_t tile = 0; tile < optimized.tileCount; ++tile) {
+    uint32_t tx = tile % optimized.tilesX;
+    uint32_t ty = tile / optimized.tilesX;
+    for (uint32_t r = optimized.tileOffsets[tile]; r < optimized.tileOffsets[tile + 1]; ++r) {
+      uint32_t ref = optimized.tileRefs[r];
+      if (r > optimized.tileOffsets[tile] && optimized.tileRefs[r - 1] >= ref) ordered = false;
+      auto const& info = optimized.cmdTiles[ref];
+      if (tx < info.tx0 || tx > info.tx1 || ty < info.ty0 || ty > info.ty1) covered = false;
+    }
+  }
+  CHECK_MESSAGE(ordered, "refs stay in command order within each tile");
+  CHECK_MESSAGE(covered, "refs land only in tiles their command covers");
+}
+
+TEST_CASE("opaque_cover_rect_drops_hidden_refs") {
+  uint32_t width = 96;
+  uint32_t height = 64;
+  auto build = [&](RenderBatch& batch) {
+    batch.tileSize = 32;
+    batch.autoTileStream = false;
+    add_clear(batch, PackRGBA8(Color{0, 0, 0, 255}));
+    add_rect(batch, 0, 0, 96, 64, PackRGBA8(Color{200, 0, 0, 255}));
+    add_rect(batch, 70, 10, 90, 30, PackRGBA8(Color{0, 0, 200, 255}));
+    add_rect(batch, 16, 0, 96, 64, PackRGBA8(Color{40, 40, 40, 255}));
+    add_rect(batch, 40, 40, 50, 50, PackRGBA8(Color{0, 200, 0, 255}));
+  };
+
+  RenderBatch batch;
+  build(batch);
+  batch.assumeFrontToBack = false;
+  std::vector<uint8_t> buffer(width * height * 4, 0);
+  RenderTarget target{std::span<uint8_t>(buffer), width, height, width * 4};
+  OptimizedBatch optimized;
+  OptimizeRenderBatch(target, batch, optimized);
+  REQUIRE(optimized.valid);
+  REQUIRE(optimized.tileCount == 6);
+
+  // Tile 0 is only partly covered by the panel; tiles 1, 2, 4 and 5 are fully covered.
+  CHECK(optimized.tileOffsets[1] - optimized.tileOffsets[0] == 2);
+  CHECK(optimized.tileRefs[optimized.tileOffsets[1]] == 3);
+  CHECK(optimized.tileOffsets[3] - optimized.tileOffsets[2] == 1);
+  CHECK(optimized.tileRefs[optimized.tileOffsets[4]] == 3);
+  CHECK(optimized.tileRefs[optimized.tileOffsets[4] + 1] == 4);
+  CHECK_MESSAGE(optimized.cmdActive[2] == 0u, "rect hidden in every tile is dropped");
+  CHECK_MESSAGE(optimized.rectActive[1] == 0u, "hidden rect skips cache build");
+
+  RenderOptimized(target, batch, optimized);
+  RenderBatch reference;
+  build(reference);
+  reference.disableOpaqueRectFastPath = true;
+  std::vector<uint8_t> expected(width * height * 4, 0);
+  RenderTarget expectedTarget{std::span<uint8_t>(expected), width, height, width * 4};
+  render_batch(expectedTarget, reference);
+  CHECK_MESSAGE(buffer == expected, "occlusion culling does not change the image");
+}
+
+TEST_CASE("sort_by_z_orders_tile_bins") {
+  uint32_t width = 64;
+  uint32_t height = 32;
+  constexpr uint32_t rectCount = 40;
+  auto z_of = [](uint32_t i) { return static_cast<int16_t>((static_cast<int32_t>((i * 7u) % 20u) - 10) * 256); };
+  auto color_of = [](uint32_t i) {
+    return PackRGBA8(Color{static_cast<uint8_t>(i * 6u), static_cast<uint8_t>(255u - i * 6u), 90, 255});
+  };
+  auto add_layer = [&](RenderBatch& batch, uint32_t i) {
+    int32_t x = static_cast<int32_t>(i % 8u) * 3;
+    add_rect(batch, x, 2, x + 20, 20, color_of(i));
+    batch.rects.zQ8_8.back() = z_of(i);
+  };
+  std::vector<uint32_t> backToFront(rectCount);
+  for (uint32_t i = 0; i < rectCount; ++i) backToFront[i] = i;
+  std::vector<uint32_t> frontToBackOrder = backToFront;
+  std::stable_sort(backToFront.begin(), backToFront.end(), [&](uint32_t a, uint32_t b) { return z_of(a) < z_of(b); });
+  std::stable_sort(frontToBackOrder.begin(), frontToBackOrder.end(), [&](uint32_t a, uint32_t b) {
+    return z_of(a) > z_of(b);
+  });
+
+  for (bool frontToBack : {false, true}) {
+    RenderBatch batch;
+    batch.tileSize = 32;
+    batch.assumeFrontToBack = frontToBack;
+    batch.autoTileStream = frontToBack;
+    batch.sortByZ = true;
+    add_clear(batch, PackRGBA8(Color{0, 0, 0, 255}));
+    for (uint32_t i = 0; i < rectCount; ++i) add_layer(batch, i);
+
+    RenderBatch reference;
+    reference.tileSize = 32;
+    reference.assumeFrontToBack = frontToBack;
+    reference.autoTileStream = frontToBack;
+    add_clear(reference, PackRGBA8(Color{0, 0, 0, 255}));
+    for (uint32_t k = 0; k < rectCount; ++k) {
+      add_layer(reference, frontToBack ? frontToBackOrder[k] : backToFront[k]);
+    }
+
+    std::vector<uint8_t> buffer(width * height * 4, 0);
+    RenderTarget target{std::span<uint8_t>(buffer), width, height, width * 4};
+    OptimizedBatch optimized;
+    OptimizeRenderBatch(target, batch, optimized);
+    REQUIRE(optimized.valid);
+    if (!frontToBack) {
+      REQUIRE(optimized.tileOffsets[1] - optimized.tileOffsets[0] == rectCount);
+      bool ordered = true;
+      for (uint32_t r = optimized.tileOffsets[0] + 1; r < optimized.tileOffsets[1]; ++r) {
+        uint32_t a = batch.commands[optimized.tileRefs[r - 1]].index;
+        uint32_t b = batch.commands[optimized.tileRefs[r]].index;
+        if (z_of(a) > z_of(b) || (z_of(a) == z_of(b) && a > b)) ordered = false;
+      }
+      CHECK_MESSAGE(ordered, "bin sorted by z, ties in command order");
+    }
+    RenderOptimized(target, batch, optimized);
+
+    std::vector<uint8_t> expected(width * height * 4, 0);
+    RenderTarget expectedTarget{std::span<uint8_t>(expected), width, height, width * 4};
+    OptimizedBatch referenceOptimized;
+    OptimizeRenderBatch(expectedTarget, reference, referenceOptimized);
+    RenderOptimized(expectedTarget, reference, referenceOptimized);
+    CHECK_MESSAGE(buffer == expected, "z-sorted bins render like pre-sorted commands");
+  }
+}
+
+TEST_CASE("large_commands_bin_once_and_merge_in_order") {
+  uint32_t width = 320;
+  uint32_t height = 240;
+  struct Layer {
+    int32_t x0, y0, x1, y1;
+    uint32_t color;
+  };
+  std::vector<Layer> layers = {
+    {0, 0, 320, 240, PackRGBA8(Color{20, 20, 20, 255})},
+    {10, 10, 30, 30, PackRGBA8(Color{200, 0, 0, 255})},
+    {40, 20, 250, 200, PackRGBA8(Color{0, 0, 200, 255})},
+    {50, 50, 70, 70, PackRGBA8(Color{0, 200, 0, 255})},
+    {0, 100, 320, 140, PackRGBA8(Color{200, 200, 0, 255})},
+    {130, 90, 150, 150, PackRGBA8(Color{0, 200, 200, 255})},
+  };
+
+  for (bool frontToBack : {false, true}) {
+    RenderBatch batch;
+    batch.tileSize = 32;
+    batch.assumeFrontToBack = frontToBack;
+    batch.autoTileStream = frontToBack;
+    for (size_t k = 0; k < layers.size(); ++k) {
+      auto const& layer = layers[frontToBack ? layers.size() - 1 - k : k];
+      add_rect(batch, layer.x0, layer.y0, layer.x1, layer.y1, layer.color);
+    }
+
+    std::vector<uint8_t> buffer(width * height * 4, 0);
+    RenderTarget target{std::span<uint8_t>(buffer), width, height, width * 4};
+    OptimizedBatch optimized;
+    OptimizeRenderBatch(target, batch, optimized);
+    REQUIRE(optimized.valid);
+    CHECK_MESSAGE(optimized.largeRefs.size() == 3, "background, panel and band are binned once");
+    CHECK_MESSAGE(optimized.tileRefs.size() < optimized.tileCount, "large commands stay out of tile refs");
+    RenderOptimized(target, batch, optimized);
+
+    std::vector<uint8_t> expected(width * height * 4, 0);
+    for (auto const& layer : layers) {
+      for (int32_t y = layer.y0; y < layer.y1; ++y) {
+        for (int32_t x = layer.x0; x < layer.x1; ++x) {
+          size_t idx = (static_cast<size_t>(y) * width + static_cast<size_t>(x)) * 4;
+          expected[idx + 0] = static_cast<uint8_t>(layer.color & 0xFFu);
+          expected[idx + 1] = static_cast<uint8_t>((layer.color >> 8) & 0xFFu);
+          expected[idx + 2] = static_cast<uint8_t>((layer.color >> 16) & 0xFFu);
+          expected[idx + 3] = 255u;
+        }
+      }
+    }
+    CHECK_MESSAGE(buffer == expected, "large commands interleave with tile refs in draw order");
+    if (frontToBack) {
+      CHECK(optimized.useTileStream);
+    }
+  }
+}
+
+TEST_CASE("hot_tiles_split_into_cost_ordered_sub_tiles") {
+  uint32_t width = 128;
+  uint32_t height = 128;
+  for (bool frontToBack : {false, true}) {
+    RenderBatch batch;
+    batch.tileSize = 32;
+    batch.assumeFrontToBack = frontToBack;
+    batch.autoTileStream = frontToBack;
+    add_clear(batch, PackRGBA8(Color{10, 10, 10, 255}));
+    add_rect(batch, 0, 0, 128, 128, PackRGBA8(Color{40, 80, 120, 128}));
+    for (int i = 0; i < 300; ++i) {
+      int32_t x = 32 + (i * 7) % 28;
+      int32_t y = 32 + (i * 5) % 28;
+      add_rect(batch, x, y, x + 5, y + 4, PackRGBA8(Color{uint8_t(30 * (i % 8)), 200, 90, 160}));
+    }
+    add_circle(batch, 48, 48, 10, PackRGBA8(Color{220, 70, 30, 200}));
+    add_rect(batch, 100, 4, 110, 20, PackRGBA8(Color{0, 200, 0, 255}));
+
+    RenderBatch uniform = batch;
+    uniform.adaptiveTiles = false;
+
+    std::vector<uint8_t> buffer(width * height * 4, 0);
+    RenderTarget target{std::span<uint8_t>(buffer), width, height, width * 4};
+    OptimizedBatch optimized;
+    OptimizeRenderBatch(target, batch, optimized);
+    REQUIRE(optimized.valid);
+    uint32_t hotIndex = 0;
+    uint32_t splitParts = 0;
+    bool merged = false;
+    std::vector<uint32_t> parts(optimized.renderTiles.size(), 0);
+    for (auto const& unit : optimized.tileWork) {
+      if (unit.split > 1) {
+        hotIndex = unit.first;
+        splitParts = unit.split * unit.split;
+      }
+      merged = merged || unit.tileCount > 1;
+      for (uint32_t i = 0; i < unit.tileCount; ++i) {
+        ++parts[unit.first + i];
+      }
+    }
+    REQUIRE_MESSAGE(splitParts > 1, "hot tile split");
+    CHECK_MESSAGE(optimized.renderTiles[hotIndex] == 5u, "split tile is the hotspot");
+    CHECK_MESSAGE(merged, "cheap tiles merged");
+    for (size_t i = 0; i < parts.size(); ++i) {
+      uint32_t expectedParts = i == hotIndex ? splitParts : 1u;
+      CHECK_MESSAGE(parts[i] == expectedParts, "every tile rendered exactly once");
+    }
+    RenderOptimized(target, batch, optimized);
+
+    std::vector<uint8_t> expected(width * height * 4, 0);
+    RenderTarget expectedTarget{std::span<uint8_t>(expected), width, height, width * 4};
+    OptimizedBatch uniformOptimized;
+    OptimizeRenderBatch(expectedTarget, uniform, uniformOptimized);
+    CHECK(uniformOptimized.tileWork.empty());
+    RenderOptimized(expectedTarget, uniform, uniformOptimized);
+    CHECK_MESSAGE(buffer == expected, "sub-tiles render the same pixels as whole tiles");
+  }
+}
+
+TEST_CASE("abutting_rects_and_pixel_runs_coalesce") {
+  uint32_t width = 96;
+  uint32_t height = 64;
+  uint32_t background = PackRGBA8(Color{10, 10, 10, 255});
+  uint32_t bar = PackRGBA8(Color{40, 160, 220, 255});
+  uint32_t cell = PackRGBA8(Color{200, 200, 60, 255});
+  uint32_t ink = PackRGBA8(Color{250, 40, 40, 255});
+  uint32_t accent = PackRGBA8(Color{20, 220, 90, 255});
+  for (bool frontToBack : {false, true}) {
+    RenderBatch batch;
+    batch.tileSize = 16;
+    batch.assumeFrontToBack = frontToBack;
+    batch.autoTileStream = frontToBack;
+    RendererProfile profile;
+    batch.profile = &profile;
+    add_clear(batch, background);
+    for (int i = 0; i < 6; ++i) {
+      add_rect(batch, i * 10, 10, i * 10 + 10, 40, bar);
+    }
+    for (int i = 0; i < 3; ++i) {
+      add_rect(batch, 70, i * 10, 90, i * 10 + 10, cell);
+    }
+    add_rect(batch, 70, 40, 90, 50, cell);
+    for (int x = 5; x < 25; ++x) {
+      add_set_pixel(batch, x, 50, ink);
+    }
+    add_set_pixel(batch, 26, 50, ink);
+    add_set_pixel(batch, 27, 50, accent);
+
+    std::vector<uint8_t> buffer(width * height * 4, 0);
+    RenderTarget target{std::span<uint8_t>(buffer), width, height, width * 4};
+    OptimizedBatch optimized;
+    OptimizeRenderBatch(target, batch, optimized);
+    REQUIRE(optimized.valid);
+    CHECK_MESSAGE(profile.coalescedCommandCount == 5u + 2u + 19u, "bar row, cell column and pixel run folded");
+    CHECK(optimized.coalescedCommands.size() == 3u);
+    RenderOptimized(target, batch, optimized);
+
+    auto expected = [&](uint32_t x, uint32_t y) -> uint32_t {
+      if (y >= 10 && y < 40 && x < 60) return bar;
+      if (x >= 70 && x < 90 && (y < 30 || (y >= 40 && y < 50))) return cell;
+      if (y == 50 && ((x >= 5 && x < 25) || x == 26)) return ink;
+      if (y == 50 && x == 27) return accent;
+      return background;
+    };
+    bool matches = true;
+    for (uint32_t y = 0; y < height; ++y) {
+      for (uint32_t x = 0; x < width; ++x) {
+        matches = matches && pixel_at(buffer, width, x, y) == expected(x, y);
+      }
+    }
+    CHECK_MESSAGE(matches, "coalesced commands paint the same pixels");
+  }
+}
+
 TEST_CASE("clear_pattern_too_large_ignored") {
   RenderBatch batch;
   enable_palette(batch, PackRGBA8(Color{0, 0, 0, 255}));
@@ -39,4 +39,101 @@ TEST_CASE("rect_cache_populated_for_active_rect") {
   CHECK_MESSAGE(optimized.rectColorR[0] == 12, "rect color cache populated");
 }
 
+TEST_CASE("large_rect_cache_offsets_follow_rect_order") {
+  RenderBatch batch;
+  enable_palette(batch, PackRGBA8(Color{200, 100, 50, 255}));
+
+  constexpr uint32_t rectCount = 5000;
+  for (uint32_t i = 0; i < rectCount; ++i) {
+    int32_t x = static_cast<int32_t>(i % 60);
+    int32_t y = static_cast<int32_t>((i / 60) % 60);
+    // Alternating heights keep neighbouring same-colour rects from coalescing.
+    add_rect(batch, x, y, x + 4, y + 4 + static_cast<int32_t>(i % 2), PackRGBA8(Color{200, 100, 50, 255}));
+    if (i % 3 == 1) {
+      batch.rects.opacity[i] = 128;
+    }
+  }
+
+  uint32_t width = 64;
+  uint32_t height = 64;
+  std::vector<uint8_t> buffer(width * height * 4, 0);
+  RenderTarget target{std::span<uint8_t>(buffer), width, height, width * 4};
+
+  OptimizedBatch optimized;
+  OptimizeRenderBatch(target, batch, optimized);
+  REQUIRE(optimized.valid);
+  REQUIRE(optimized.rectEdgeOffset.size() == rectCount);
+
+  uint32_t expectedOffset = 0;
+  bool offsetsOk = true;
+  for (uint32_t i = 0; i < rectCount; ++i) {
+    if (i % 3 == 1) {
+      offsetsOk = offsetsOk && optimized.rectEdgeOffset[i] == 0xFFFFFFFFu;
+      continue;
+    }
+    offsetsOk = offsetsOk && optimized.rectEdgeOffset[i] == expectedOffset;
+    expectedOffset += 256u;
+  }
+  CHECK_MESSAGE(offsetsOk, "opaque rects get consecutive LUT offsets in rect order");
+  REQUIRE(optimized.rectEdgePmRStore.size() == expectedOffset);
+
+  uint32_t last = optimized.rectEdgeOffset[rectCount - 2];
+  CHECK(optimized.rectEdgePmRStore[last + 255] == 200);
+  CHECK(optimized.rectEdgePmGStore[last + 128] == static_cast<uint8_t>((100u * 128u + 127u) / 255u));
+  CHECK(optimized.rectEdgePmBStore[last + 0] == 0);
+  CHECK(optimized.rectBaseAlpha[1] == 128);
+}
+
+TEST_CASE("packed_rect_records_match_soa_cache") {
+  uint32_t width = 64;
+  uint32_t height = 64;
+  for (bool frontToBack : {false, true}) {
+    RenderBatch batch;
+    batch.assumeFrontToBack = frontToBack;
+    batch.autoTileStream = frontToBack;
+    batch.tileSize = 16;
+    add_clear(batch, PackRGBA8(Color{10, 10, 10, 255}));
+    add_rect(batch, 2, 2, 30, 20, PackRGBA8(Color{200, 100, 0, 255}));
+    add_rect(batch, 20, 10, 50, 40, PackRGBA8(Color{40, 160, 220, 128}));
+    batch.rects.opacity[1] = 200;
+    add_rect(batch, 8, 30, 40, 60, PackRGBA8(Color{90, 220, 40, 255}));
+    batch.rects.radiusQ8_8[2] = 6 * 256;
+    add_rect(batch, 36, 4, 60, 28, PackRGBA8(Color{200, 100, 0, 255}));
+    batch.rects.rotationQ8_8[3] = 64;
+    add_rect(batch, 0, 44, 64, 64, PackRGBA8(Color{40, 160, 220, 128}));
+    batch.rects.flags[4] = RectFlagClip;
+    batch.rects.clipX0[4] = 10;
+    batch.rects.clipY0[4] = 48;
+    batch.rects.clipX1[4] = 50;
+    batch.rects.clipY1[4] = 60;
+    add_gradient_rect_dir(batch, 44, 34, 62, 62, PackRGBA8(Color{255, 0, 0, 255}),
+                          PackRGBA8(Color{0, 0, 255, 255}), 256, 128);
+
+    RenderBatch soa = batch;
+    soa.packRectRecords = false;
+
+    std::vector<uint8_t> buffer(width * height * 4, 0);
+    RenderTarget target{std::span<uint8_t>(buffer), width, height, width * 4};
+    OptimizedBatch optimized;
+    OptimizeRenderBatch(target, batch, optimized);
+    REQUIRE(optimized.rectRecords.size() == batch.rects.x0.size());
+    auto const& opaque = optimized.rectRecords[0];
+    CHECK(opaque.x1 == 30);
+    CHECK(opaque.colorR == 200);
+    CHECK(opaque.edgeOffset == optimized.rectEdgeOffset[0]);
+    CHECK(optimized.rectRecords[1].baseAlpha == optimized.rectBaseAlpha[1]);
+    CHECK(optimized.rectRecords[4].cacheFlags == OptimizedBatch::RectRecordClip);
+    CHECK(optimized.rectRecords[5].cacheFlags == OptimizedBatch::RectRecordGradient);
+    RenderOptimized(target, batch, optimized);
+
+    std::vector<uint8_t> expected(width * height * 4, 0);
+    RenderTarget expectedTarget{std::span<uint8_t>(expected), width, height, width * 4};
+    OptimizedBatch soaOptimized;
+    OptimizeRenderBatch(expectedTarget, soa, soaOptimized);
+    CHECK(soaOptimized.rectRecords.empty());
+    RenderOptimized(expectedTarget, soa, soaOptimized);
+    CHECK_MESSAGE(buffer == expected, "packed records render the same pixels as the SoA cache");
+  }
+}
+
 TEST_SUITE_END();
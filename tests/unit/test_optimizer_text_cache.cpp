@@ -53,4 +53,58 @@ TEST_CASE("text_cache_populated_for_active_text") {
   CHECK_MESSAGE(optimized.textColorR[0] == 10, "text color cache populated");
 }
 
+TEST_CASE("long_text_runs_get_glyph_spans") {
+  auto build = [](bool reversed) {
+    RenderBatch batch;
+    batch.tileSize = 8;
+    add_clear(batch, PackRGBA8(Color{0, 0, 0, 255}));
+    GlyphStore::GlyphBitmap bitmap;
+    bitmap.width = 3;
+    bitmap.height = 4;
+    bitmap.bearingX = 1;
+    bitmap.bearingY = 4;
+    bitmap.stride = 3;
+    bitmap.pixels = {40, 255, 40, 255, 128, 255, 255, 255, 255, 90, 0, 90};
+    batch.glyphs.bitmaps.push_back(bitmap);
+    batch.glyphs.bitmapOpaque.push_back(0);
+    constexpr int32_t Count = 24;
+    for (int32_t i = 0; i < Count; ++i) {
+      int32_t slot = reversed ? Count - 1 - i : i;
+      batch.glyphs.glyphXQ8_8.push_back(slot * 5 * 256 + 64);
+      batch.glyphs.glyphYQ8_8.push_back(0);
+      batch.glyphs.bitmapIndex.push_back(0);
+    }
+    batch.runs.glyphStart.push_back(0);
+    batch.runs.glyphCount.push_back(Count);
+    batch.runs.baselineQ8_8.push_back(4 * 256);
+    batch.runs.scaleQ8_8.push_back(256);
+    add_text(batch, 3, 2, 120, 6, PackRGBA8(Color{200, 160, 20, 255}), 0);
+    add_text(batch, -7, 10, 120, 6, PackRGBA8(Color{20, 160, 200, 255}), 0);
+    return batch;
+  };
+
+  uint32_t width = 128;
+  uint32_t height = 16;
+  std::vector<uint8_t> probeBuffer(width * height * 4, 0);
+  RenderTarget probe{std::span<uint8_t>(probeBuffer), width, height, width * 4};
+
+  RenderBatch forward = build(false);
+  OptimizedBatch optimized;
+  OptimizeRenderBatch(probe, forward, optimized);
+  REQUIRE(optimized.textRunSpanOffset.size() == 1);
+  CHECK_MESSAGE(optimized.textRunSpanOffset[0] == 0, "x-ordered long run gets spans");
+  CHECK_MESSAGE(optimized.textGlyphSpanX0.size() == 24, "one span per glyph, shared by both entries");
+
+  RenderBatch backward = build(true);
+  OptimizeRenderBatch(probe, backward, optimized);
+  REQUIRE(optimized.textRunSpanOffset.size() == 1);
+  CHECK_MESSAGE(optimized.textRunSpanOffset[0] == 0xFFFFFFFFu, "unordered run keeps the full glyph loop");
+
+  std::vector<uint8_t> a(width * height * 4, 0);
+  std::vector<uint8_t> b(width * height * 4, 0);
+  render_batch(RenderTarget{std::span<uint8_t>(a), width, height, width * 4}, forward);
+  render_batch(RenderTarget{std::span<uint8_t>(b), width, height, width * 4}, backward);
+  CHECK_MESSAGE(a == b, "span-culled glyph loop draws the same pixels");
+}
+
 TEST_SUITE_END();
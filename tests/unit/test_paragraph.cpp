@@ -0,0 +1,99 @@
+#include "PrimeManifest/text/FontRegistry.hpp"
+#include "PrimeManifest/text/Paragraph.hpp"
+
+#include "third_party/doctest.h"
+
+#include <memory>
+#include <string_view>
+
+using namespace PrimeManifest;
+
+namespace {
+
+auto make_monospace_run(std::string_view text, float advance) -> std::shared_ptr<TextRun> {
+  auto run = std::make_shared<TextRun>();
+  run->height = 10.0f;
+  run->baseline = 8.0f;
+  float penX = 0.0f;
+  for (size_t i = 0; i < text.size(); ++i) {
+    GlyphPlacement placement;
+    placement.glyphId = static_cast<int32_t>(text[i]);
+    placement.x = penX;
+    placement.cluster = static_cast<uint32_t>(i);
+    placement.advance = advance;
+    run->glyphs.push_back(placement);
+    penX += advance;
+  }
+  run->width = penX;
+  return run;
+}
+
+} // namespace
+
+TEST_SUITE_BEGIN("primemanifest.paragraph");
+
+TEST_CASE("line_breaks_after_spaces_and_hyphens") {
+  auto breaks = FindLineBreaks("ab cd-ef  gh");
+  REQUIRE(breaks.size() == 3);
+  CHECK_MESSAGE(breaks[0].byteOffset == 3, "break after space");
+  CHECK_MESSAGE(breaks[1].byteOffset == 6, "break after hyphen");
+  CHECK_MESSAGE(breaks[2].byteOffset == 10, "break after space run");
+  CHECK_MESSAGE(!breaks[0].mandatory, "space break is optional");
+}
+
+TEST_CASE("line_breaks_mandatory_and_prohibited") {
+  auto breaks = FindLineBreaks("a\r\nb\nc");
+  REQUIRE(breaks.size() == 2);
+  CHECK_MESSAGE(breaks[0].byteOffset == 3, "crlf breaks once");
+  CHECK_MESSAGE(breaks[0].mandatory, "crlf break is mandatory");
+  CHECK_MESSAGE(breaks[1].byteOffset == 5, "lf break");
+
+  CHECK_MESSAGE(FindLineBreaks("a\xC2\xA0" "b").empty(), "no break at no-break space");
+  CHECK_MESSAGE(FindLineBreaks("a !").empty(), "no break before closing punctuation");
+  CHECK_MESSAGE(FindLineBreaks("x -5").size() == 1, "no break between hyphen and number");
+  CHECK_MESSAGE(FindLineBreaks("\xE4\xB8\x80\xE4\xBA\x8C").size() == 1, "break between ideographs");
+}
+
+TEST_CASE("wrap_paragraph_rewraps_without_reshaping") {
+  std::string_view text = "aaa bbb ccc";
+  auto paragraph = BuildParagraphLayout(text, make_monospace_run(text, 1.0f));
+  CHECK_MESSAGE(paragraph.glyphFlags.size() == text.size(), "flags per glyph");
+
+  auto narrow = WrapParagraph(paragraph, 5.0f);
+  REQUIRE(narrow.size() == 3);
+  CHECK_MESSAGE(narrow[0].width == doctest::Approx(3.0f), "trailing space hangs");
+  CHECK_MESSAGE(narrow[1].glyphs.front().x == doctest::Approx(0.0f), "line glyphs rebased");
+  CHECK_MESSAGE(narrow[1].glyphs.front().cluster == 4, "second line starts after the break");
+  CHECK_MESSAGE(narrow[2].height == doctest::Approx(10.0f), "line height copied");
+
+  auto wide = WrapParagraph(paragraph, 7.0f);
+  REQUIRE(wide.size() == 2);
+  CHECK_MESSAGE(wide[0].width == doctest::Approx(7.0f), "two words fit on the first line");
+
+  auto unbounded = WrapParagraph(paragraph, 0.0f);
+  CHECK_MESSAGE(unbounded.size() == 1, "no width keeps a single line");
+}
+
+TEST_CASE("wrap_paragraph_breaks_long_words_and_newlines") {
+  std::string_view text = "abcdefgh\nij\n";
+  auto paragraph = BuildParagraphLayout(text, make_monospace_run(text, 1.0f));
+  auto lines = WrapParagraph(paragraph, 5.0f);
+  REQUIRE(lines.size() == 4);
+  CHECK_MESSAGE(lines[0].glyphs.size() == 5, "overlong word split at width");
+  CHECK_MESSAGE(lines[1].glyphs.size() == 3, "remainder drops the newline glyph");
+  CHECK_MESSAGE(lines[2].glyphs.size() == 2, "mandatory break starts a line");
+  CHECK_MESSAGE(lines[3].glyphs.empty(), "trailing newline yields an empty line");
+}
+
+TEST_CASE("layout_paragraph_uses_registry") {
+  FontRegistry registry;
+  Typography typography;
+  typography.size = 14.0f;
+  auto paragraph = registry.layoutParagraph("hello wide world", typography, 1.0f, false);
+  if (!paragraph) return;
+  CHECK_MESSAGE(paragraph->run, "paragraph keeps shaped run");
+  auto lines = WrapParagraph(*paragraph, paragraph->run->width * 0.5f);
+  CHECK_MESSAGE(lines.size() >= 2, "paragraph wraps at half width");
+}
+
+TEST_SUITE_END();
@@ -171,6 +171,7 @@ TEST_CASE("gradient_dir_normalized_in_renderer") {
   OptimizedBatch optimized;
   OptimizeRenderBatch(target, batch, optimized);
   optimized.rectHasGradient.clear();
+  optimized.rectRecords.clear();
 
   RenderOptimized(target, batch, optimized);
 
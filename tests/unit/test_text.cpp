@@ -1,4 +1,6 @@
 #include "test_helpers.hpp"
+#include "PrimeManifest/text/FontBitmap.hpp"
+#include "PrimeManifest/text/TextBake.hpp"
 #include "third_party/doctest.h"
 
 using namespace PrimeManifest;
@@ -581,4 +583,180 @@ TEST_CASE("scale_applies") {
                 "scaled text draws at origin");
 }
 
+TEST_CASE("sdf_glyph_scales_with_run_glyph_scale") {
+  RenderBatch batch;
+  add_clear(batch, PackRGBA8(Color{0, 0, 0, 255}));
+
+  std::vector<uint8_t> coverage(16, 255);
+  GlyphStore::GlyphBitmap bitmap;
+  bitmap.format = GlyphBitmapFormat::Sdf8;
+  CHECK(BuildGlyphDistanceField(coverage.data(), 4, 4, 4, GlyphSdfSpread, bitmap.pixels, bitmap.width, bitmap.height));
+  bitmap.stride = bitmap.width;
+  bitmap.bearingX = -GlyphSdfSpread;
+  bitmap.bearingY = GlyphSdfSpread;
+  batch.glyphs.bitmaps.push_back(bitmap);
+  batch.glyphs.bitmapOpaque.push_back(0);
+
+  batch.glyphs.glyphXQ8_8.push_back(0);
+  batch.glyphs.glyphYQ8_8.push_back(0);
+  batch.glyphs.bitmapIndex.push_back(0);
+
+  batch.runs.glyphStart.push_back(0);
+  batch.runs.glyphCount.push_back(1);
+  batch.runs.baselineQ8_8.push_back(0);
+  batch.runs.scaleQ8_8.push_back(256);
+  batch.runs.glyphScaleQ8_8.push_back(512);
+
+  add_text(batch, 4, 4, 8, 8, PackRGBA8(Color{0, 200, 0, 255}), 0);
+
+  uint32_t width = 16;
+  uint32_t height = 16;
+  std::vector<uint8_t> buffer(width * height * 4, 0);
+  RenderTarget target{std::span<uint8_t>(buffer), width, height, width * 4};
+
+  render_batch(target, batch);
+
+  uint32_t expected = PackRGBA8(Color{0, 200, 0, 255});
+  uint32_t background = PackRGBA8(Color{0, 0, 0, 255});
+  CHECK_MESSAGE(pixel_at(buffer, width, 4, 7) == expected, "sdf glyph covers scaled left edge");
+  CHECK_MESSAGE(pixel_at(buffer, width, 11, 8) == expected, "sdf glyph covers scaled right edge");
+  CHECK_MESSAGE(pixel_at(buffer, width, 13, 13) == background, "sdf glyph leaves outside untouched");
+  CHECK_MESSAGE(pixel_at(buffer, width, 2, 7) == background, "sdf glyph padding stays transparent");
+}
+
+TEST_CASE("subpixel_glyph_variant_offsets_placement") {
+  RenderBatch batch;
+  add_clear(batch, PackRGBA8(Color{0, 0, 0, 255}));
+
+  GlyphStore::GlyphBitmap bitmap;
+  bitmap.width = 1;
+  bitmap.height = 1;
+  bitmap.stride = 1;
+  bitmap.pixels = {255};
+  bitmap.subpixelBin = 2;
+  batch.glyphs.bitmaps.push_back(bitmap);
+  batch.glyphs.bitmapOpaque.push_back(1);
+
+  batch.glyphs.glyphXQ8_8.push_back(128);
+  batch.glyphs.glyphYQ8_8.push_back(0);
+  batch.glyphs.bitmapIndex.push_back(0);
+
+  batch.runs.glyphStart.push_back(0);
+  batch.runs.glyphCount.push_back(1);
+  batch.runs.baselineQ8_8.push_back(0);
+  batch.runs.scaleQ8_8.push_back(256);
+
+  add_text(batch, 1, 1, 2, 1, PackRGBA8(Color{0, 200, 0, 255}), 0);
+
+  uint32_t width = 4;
+  uint32_t height = 4;
+  std::vector<uint8_t> buffer(width * height * 4, 0);
+  RenderTarget target{std::span<uint8_t>(buffer), width, height, width * 4};
+
+  render_batch(target, batch);
+
+  CHECK_MESSAGE(pixel_at(buffer, width, 1, 1) == PackRGBA8(Color{0, 200, 0, 255}),
+                "half-pixel variant lands on the integer origin");
+  CHECK_MESSAGE(pixel_at(buffer, width, 2, 1) == PackRGBA8(Color{0, 0, 0, 255}),
+                "half-pixel variant is not rounded up");
+}
+
+TEST_CASE("text_sprite_matches_per_glyph_rendering") {
+  auto build = [](bool sprite, bool overlap) {
+    RenderBatch batch;
+    add_clear(batch, PackRGBA8(Color{20, 30, 40, 255}));
+    GlyphStore::GlyphBitmap a;
+    a.width = 3;
+    a.height = 3;
+    a.bearingY = 3;
+    a.stride = 3;
+    a.pixels = {0, 64, 255, 128, 255, 32, 255, 200, 10};
+    GlyphStore::GlyphBitmap b = a;
+    b.subpixelBin = 2;
+    b.pixels = {90, 0, 180, 255, 40, 0, 7, 255, 255};
+    batch.glyphs.bitmaps.push_back(a);
+    batch.glyphs.bitmaps.push_back(b);
+    batch.glyphs.bitmapOpaque = {0, 0};
+    int32_t step = overlap ? 2 : 4;
+    for (int32_t i = 0; i < 4; ++i) {
+      batch.glyphs.glyphXQ8_8.push_back((i * step) * 256 + (i % 2) * 128);
+      batch.glyphs.glyphYQ8_8.push_back((i % 2) * 256);
+      batch.glyphs.bitmapIndex.push_back(static_cast<uint32_t>(i % 2));
+    }
+    batch.runs.glyphStart.push_back(0);
+    batch.runs.glyphCount.push_back(4);
+    batch.runs.baselineQ8_8.push_back(4 * 256);
+    batch.runs.scaleQ8_8.push_back(256);
+    add_text(batch, 2, 1, 16, 6, PackRGBA8(Color{250, 120, 10, 255}), 0);
+    add_text(batch, 3, 8, 16, 6, PackRGBA8(Color{10, 220, 90, 255}), 0);
+    batch.text.opacity[1] = 150;
+    if (sprite) {
+      batch.text.flags[0] |= TextFlagSprite;
+      batch.text.flags[1] |= TextFlagSprite;
+      CHECK(BuildTextRunSprite(batch, 0));
+      CHECK(batch.runs.sprites.size() == 1);
+    }
+    std::vector<uint8_t> buffer(24 * 16 * 4, 0);
+    RenderTarget target{std::span<uint8_t>(buffer), 24, 16, 24 * 4};
+    render_batch(target, batch);
+    return buffer;
+  };
+
+  CHECK_MESSAGE(build(true, false) == build(false, false), "sprite blit matches per-glyph blending");
+
+  auto sprite = build(true, true);
+  auto glyphs = build(false, true);
+  // Only the opaque label: translucent overlaps differ by design, the sprite applies opacity once.
+  int maxDiff = 0;
+  for (size_t i = 0; i < static_cast<size_t>(24 * 8 * 4); ++i) {
+    maxDiff = std::max(maxDiff, std::abs(static_cast<int>(sprite[i]) - static_cast<int>(glyphs[i])));
+  }
+  CHECK_MESSAGE(maxDiff <= 2, "overlapping glyphs merge like successive blends");
+}
+
+TEST_CASE("span_encoded_glyphs_match_dense_rendering") {
+  GlyphStore::GlyphBitmap dense;
+  dense.width = 12;
+  dense.height = 5;
+  dense.bearingY = 5;
+  dense.stride = 12;
+  dense.pixels = {0,   0,   40,  255, 255, 255, 255, 90,  0,   0,   0,   0,
+                  0,   128, 255, 255, 0,   0,   255, 255, 200, 0,   0,   0,
+                  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+                  0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+                  17,  0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   33};
+
+  GlyphStore::GlyphBitmap encoded = dense;
+  REQUIRE(EncodeGlyphMaskSpans(encoded));
+  CHECK_MESSAGE(encoded.pixels.empty(), "dense coverage dropped");
+  CHECK_MESSAGE(encoded.maskSpanRows.size() == 6, "one offset per row plus end");
+  CHECK_MESSAGE(encoded.maskSpans.size() < dense.pixels.size(), "spans are smaller than the mask");
+  CHECK_MESSAGE(encoded.maskSpanRows[3] == encoded.maskSpanRows[4], "empty row has no tokens");
+
+  auto render = [](GlyphStore::GlyphBitmap const& bitmap, uint8_t opacity) {
+    RenderBatch batch;
+    batch.tileSize = 8;
+    add_clear(batch, PackRGBA8(Color{30, 30, 60, 255}));
+    batch.glyphs.bitmaps.push_back(bitmap);
+    batch.glyphs.bitmapOpaque.push_back(0);
+    for (int32_t i = 0; i < 3; ++i) {
+      batch.glyphs.glyphXQ8_8.push_back(i * 9 * 256);
+      batch.glyphs.glyphYQ8_8.push_back(i * 256);
+      batch.glyphs.bitmapIndex.push_back(0);
+    }
+    batch.runs.glyphStart.push_back(0);
+    batch.runs.glyphCount.push_back(3);
+    batch.runs.baselineQ8_8.push_back(5 * 256);
+    batch.runs.scaleQ8_8.push_back(256);
+    add_text(batch, 3, 2, 36, 8, PackRGBA8(Color{240, 200, 40, 255}), 0);
+    batch.text.opacity[0] = opacity;
+    std::vector<uint8_t> buffer(40 * 12 * 4, 0);
+    render_batch(RenderTarget{std::span<uint8_t>(buffer), 40, 12, 40 * 4}, batch);
+    return buffer;
+  };
+
+  CHECK_MESSAGE(render(encoded, 255) == render(dense, 255), "opaque text matches");
+  CHECK_MESSAGE(render(encoded, 140) == render(dense, 140), "translucent text matches");
+}
+
 TEST_SUITE_END();
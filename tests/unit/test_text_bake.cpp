@@ -1,7 +1,9 @@
 #include "PrimeManifest/text/TextBake.hpp"
 
+#include "test_helpers.hpp"
 #include "third_party/doctest.h"
 
+#include <algorithm>
 #include <memory>
 
 using namespace PrimeManifest;
@@ -48,6 +50,283 @@ TEST_CASE("append_text_run_copies_bitmaps") {
   CHECK_MESSAGE(batch.text.colorIndex[0] == 7, "text color index stored");
 }
 
+TEST_CASE("append_text_run_shares_bitmaps_across_runs") {
+  RenderBatch batch;
+
+  GlyphBitmap glyphE;
+  glyphE.width = 1;
+  glyphE.height = 1;
+  glyphE.advance = 1;
+  glyphE.stride = 1;
+  glyphE.pixels = {255};
+  glyphE.identity = GlyphIdentity{1, 1, 1, 12};
+
+  GlyphBitmap glyphX;
+  glyphX.width = 1;
+  glyphX.height = 1;
+  glyphX.advance = 1;
+  glyphX.stride = 1;
+  glyphX.pixels = {128};
+  glyphX.identity = GlyphIdentity{1, 1, 2, 12};
+
+  TextRun first;
+  first.width = 2.0f;
+  first.height = 1.0f;
+  first.glyphs.push_back(GlyphPlacement{&glyphE, 1, 0.0f, 0.0f});
+  first.glyphs.push_back(GlyphPlacement{&glyphX, 2, 1.0f, 0.0f});
+
+  TextRun second;
+  second.width = 1.0f;
+  second.height = 1.0f;
+  second.glyphs.push_back(GlyphPlacement{&glyphE, 1, 0.0f, 0.0f});
+
+  CHECK(AppendTextRun(batch, first, 0, 0, 1).has_value());
+  CHECK(AppendTextRun(batch, second, 0, 10, 1).has_value());
+  CHECK_MESSAGE(batch.glyphs.bitmaps.size() == 2, "bitmaps shared across runs");
+  CHECK_MESSAGE(batch.glyphs.bitmapOpaque.size() == 2, "opacity computed once per bitmap");
+  CHECK_MESSAGE(batch.glyphs.bitmapIndex[2] == batch.glyphs.bitmapIndex[0], "second run reuses bitmap");
+
+  batch.text.clear();
+  batch.runs.clear();
+  batch.commands.clear();
+  batch.glyphs.clearPlacements();
+  CHECK_MESSAGE(batch.glyphs.size() == 0, "placements cleared");
+  CHECK(AppendTextRun(batch, second, 0, 0, 1).has_value());
+  CHECK_MESSAGE(batch.glyphs.bitmaps.size() == 2, "bitmap table kept across frames");
+  CHECK_MESSAGE(batch.glyphs.bitmapIndex[0] == 0, "retained bitmap reused");
+
+  batch.glyphs.clear();
+  CHECK_MESSAGE(batch.glyphs.bitmapLookup.empty(), "clear drops bitmap lookup");
+}
+
+TEST_CASE("append_text_run_does_not_share_bitmaps_by_address") {
+  RenderBatch batch;
+
+  GlyphBitmap glyph;
+  glyph.width = 1;
+  glyph.height = 1;
+  glyph.stride = 1;
+  glyph.pixels = {255};
+
+  TextRun run;
+  run.width = 1.0f;
+  run.height = 1.0f;
+  run.glyphs.push_back(GlyphPlacement{&glyph, 1, 0.0f, 0.0f});
+
+  REQUIRE(AppendTextRun(batch, run, 0, 0, 1).has_value());
+  // The same address now holds a different glyph, as after its owner freed and reallocated it.
+  glyph.pixels = {64};
+  REQUIRE(AppendTextRun(batch, run, 0, 0, 1).has_value());
+  REQUIRE(batch.glyphs.bitmaps.size() == 2);
+  CHECK_MESSAGE(batch.glyphs.bitmaps[batch.glyphs.bitmapIndex[1]].pixels[0] == 64, "new bitmap copied");
+  CHECK_MESSAGE(batch.glyphs.bitmapLookup.empty(), "caller-owned addresses are not retained");
+
+  GlyphBitmap copy = glyph;
+  copy.identity = GlyphIdentity{7, 2, 9, 12};
+  glyph.identity = copy.identity;
+  run.glyphs.push_back(GlyphPlacement{&copy, 1, 1.0f, 0.0f});
+  REQUIRE(AppendTextRun(batch, run, 0, 0, 1).has_value());
+  CHECK_MESSAGE(batch.glyphs.bitmaps.size() == 3, "bitmaps with the same identity share one copy");
+  CHECK(batch.glyphs.bitmapIndex[2] == batch.glyphs.bitmapIndex[3]);
+
+  GlyphBitmap shifted = copy;
+  shifted.identity.subpixelBin = 1;
+  GlyphBitmap otherRegistry = copy;
+  otherRegistry.identity.registry = 8;
+  run.glyphs = {GlyphPlacement{&shifted, 1, 0.0f, 0.0f}, GlyphPlacement{&otherRegistry, 1, 1.0f, 0.0f}};
+  REQUIRE(AppendTextRun(batch, run, 0, 0, 1).has_value());
+  CHECK_MESSAGE(batch.glyphs.bitmaps.size() == 5, "identities differing in any field never share");
+}
+
+TEST_CASE("append_text_run_reuses_baked_runs") {
+  RenderBatch batch;
+
+  GlyphBitmap glyph;
+  glyph.width = 1;
+  glyph.height = 1;
+  glyph.stride = 1;
+  glyph.pixels = {255};
+
+  TextRun label;
+  label.width = 2.0f;
+  label.height = 1.0f;
+  label.contentHash = 0x1234u;
+  label.glyphs.push_back(GlyphPlacement{&glyph, 1, 0.0f, 0.0f});
+  label.glyphs.push_back(GlyphPlacement{&glyph, 1, 1.0f, 0.0f});
+
+  auto first = AppendTextRun(batch, label, 0, 0, 1);
+  REQUIRE(first.has_value());
+  size_t glyphsAfterFirst = batch.glyphs.size();
+
+  batch.text.clear();
+  batch.commands.clear();
+  auto again = AppendTextRun(batch, label, 5, 6, 2, 128, 1);
+  REQUIRE(again.has_value());
+  CHECK_MESSAGE(again->runIndex == first->runIndex, "unchanged label reuses its run");
+  CHECK_MESSAGE(batch.glyphs.size() == glyphsAfterFirst, "no glyphs re-baked");
+  CHECK_MESSAGE(batch.runs.size() == 1, "no run appended");
+  CHECK(batch.text.colorIndex[again->textIndex] == 2);
+  CHECK(batch.text.x[again->textIndex] == 5);
+
+  TextRun scaled = label;
+  scaled.layoutScale = 2.0f;
+  auto other = AppendTextRun(batch, scaled, 0, 0, 1);
+  REQUIRE(other.has_value());
+  CHECK_MESSAGE(other->runIndex != first->runIndex, "different scale bakes a new run");
+
+  TextRun unhashed = label;
+  unhashed.contentHash = 0;
+  auto a = AppendTextRun(batch, unhashed, 0, 0, 1);
+  auto b = AppendTextRun(batch, unhashed, 0, 0, 1);
+  REQUIRE(a.has_value());
+  REQUIRE(b.has_value());
+  CHECK_MESSAGE(a->runIndex != b->runIndex, "runs without a content hash are not cached");
+
+  batch.runs.clear();
+  batch.glyphs.clearPlacements();
+  auto rebaked = AppendTextRun(batch, label, 0, 0, 1);
+  REQUIRE(rebaked.has_value());
+  CHECK_MESSAGE(batch.glyphs.size() == 2, "cleared runs are baked again");
+}
+
+TEST_CASE("append_text_run_rebakes_after_placements_cleared") {
+  RenderBatch batch;
+  uint8_t ink = PrimeManifestTest::palette_index(batch, PackRGBA8(Color{255, 255, 255, 255}));
+  uint32_t background = PackRGBA8(Color{0, 0, 0, 255});
+
+  GlyphBitmap wide;
+  wide.width = 3;
+  wide.height = 2;
+  wide.bearingY = 3;
+  wide.stride = 3;
+  wide.pixels.assign(6, 255);
+
+  GlyphBitmap tall;
+  tall.width = 1;
+  tall.height = 3;
+  tall.bearingY = 3;
+  tall.stride = 1;
+  tall.pixels.assign(3, 255);
+
+  TextRun labelA;
+  labelA.width = 3.0f;
+  labelA.height = 3.0f;
+  labelA.baseline = 3.0f;
+  labelA.contentHash = 0xA;
+  labelA.glyphs.push_back(GlyphPlacement{&wide, 1, 0.0f, 0.0f});
+
+  TextRun labelB = labelA;
+  labelB.contentHash = 0xB;
+  labelB.glyphs[0] = GlyphPlacement{&tall, 2, 0.0f, 0.0f};
+
+  REQUIRE(AppendTextRun(batch, labelA, 2, 4, ink).has_value());
+
+  batch.text.clear();
+  batch.commands.clear();
+  batch.glyphs.clearPlacements();
+  PrimeManifestTest::add_clear(batch, background);
+  REQUIRE(AppendTextRun(batch, labelB, 10, 4, ink).has_value());
+  auto again = AppendTextRun(batch, labelA, 2, 4, ink);
+  REQUIRE(again.has_value());
+  CHECK_MESSAGE(again->runIndex != 0u, "run baked before clearPlacements is not reused");
+
+  uint32_t width = 16;
+  uint32_t height = 16;
+  std::vector<uint8_t> buffer(width * height * 4, 0);
+  PrimeManifestTest::render_batch(RenderTarget{std::span<uint8_t>(buffer), width, height, width * 4}, batch);
+  uint32_t labelAPixels = 0;
+  uint32_t labelBPixels = 0;
+  for (uint32_t y = 0; y < height; ++y) {
+    for (uint32_t x = 0; x < width; ++x) {
+      if (PrimeManifestTest::pixel_at(buffer, width, x, y) == background) continue;
+      ++(x < 8 ? labelAPixels : labelBPixels);
+    }
+  }
+  CHECK_MESSAGE(labelAPixels == 6u, "re-baked label draws its own glyph");
+  CHECK_MESSAGE(labelBPixels == 3u, "other label unaffected");
+}
+
+TEST_CASE("trim_text_runs_bounds_retained_stores") {
+  RenderBatch batch;
+  uint8_t ink = PrimeManifestTest::palette_index(batch, PackRGBA8(Color{255, 255, 255, 255}));
+  uint32_t background = PackRGBA8(Color{0, 0, 0, 255});
+
+  GlyphBitmap stable;
+  stable.width = 2;
+  stable.height = 2;
+  stable.bearingY = 2;
+  stable.stride = 2;
+  stable.pixels.assign(4, 255);
+  stable.identity = GlyphIdentity{1, 1, 1, 12};
+
+  TextRun label;
+  label.width = 2.0f;
+  label.height = 2.0f;
+  label.baseline = 2.0f;
+  label.contentHash = 0x5150u;
+  label.glyphs.push_back(GlyphPlacement{&stable, 1, 0.0f, 0.0f});
+
+  size_t maxRuns = 0;
+  size_t maxGlyphs = 0;
+  size_t maxBitmaps = 0;
+  for (uint32_t frame = 0; frame < 64; ++frame) {
+    batch.text.clear();
+    batch.commands.clear();
+    PrimeManifestTest::add_clear(batch, background);
+
+    GlyphBitmap counter;
+    counter.width = 1;
+    counter.height = 1;
+    counter.bearingY = 1;
+    counter.stride = 1;
+    counter.pixels = {255};
+    counter.identity = GlyphIdentity{1, 1, 100 + frame, 12};
+    TextRun changing;
+    changing.width = 3.0f;
+    changing.height = 1.0f;
+    changing.baseline = 1.0f;
+    changing.contentHash = 0x10000u + frame;
+    for (int i = 0; i < 3; ++i) {
+      changing.glyphs.push_back(GlyphPlacement{&counter, static_cast<int32_t>(100 + frame), static_cast<float>(i), 0.0f});
+    }
+
+    REQUIRE(AppendTextRun(batch, changing, 8, 0, ink, 255, TextFlagSprite).has_value());
+    REQUIRE(AppendTextRun(batch, label, 0, 0, ink).has_value());
+    TrimTextRuns(batch);
+    maxRuns = std::max(maxRuns, batch.runs.size());
+    maxGlyphs = std::max(maxGlyphs, batch.glyphs.size());
+    maxBitmaps = std::max(maxBitmaps, batch.glyphs.bitmaps.size());
+  }
+  CHECK_MESSAGE(maxRuns == 2u, "only this frame's runs are retained");
+  CHECK(maxGlyphs == 4u);
+  CHECK(maxBitmaps == 2u);
+  CHECK(batch.glyphs.bitmapLookup.size() == 2u);
+  CHECK(batch.runs.bakedLookup.size() == 2u);
+  CHECK(batch.runs.sprites.size() == 1u);
+
+  size_t glyphsBefore = batch.glyphs.size();
+  batch.text.clear();
+  batch.commands.clear();
+  PrimeManifestTest::add_clear(batch, background);
+  auto reused = AppendTextRun(batch, label, 0, 0, ink);
+  REQUIRE(reused.has_value());
+  CHECK_MESSAGE(batch.glyphs.size() == glyphsBefore, "surviving run is still reused after trimming");
+  CHECK(TrimTextRuns(batch) == 1u);
+  CHECK(batch.text.runIndex[0] == reused->runIndex);
+
+  uint32_t width = 8;
+  uint32_t height = 8;
+  std::vector<uint8_t> buffer(width * height * 4, 0);
+  PrimeManifestTest::render_batch(RenderTarget{std::span<uint8_t>(buffer), width, height, width * 4}, batch);
+  uint32_t inked = 0;
+  for (uint32_t y = 0; y < height; ++y) {
+    for (uint32_t x = 0; x < width; ++x) {
+      if (PrimeManifestTest::pixel_at(buffer, width, x, y) != background) ++inked;
+    }
+  }
+  CHECK_MESSAGE(inked == 4u, "renumbered run draws its glyph");
+}
+
 TEST_CASE("append_text_run_copies_atlas_pixels") {
   RenderBatch batch;
 